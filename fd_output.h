@@ -0,0 +1,160 @@
+#ifndef COMP6771_ASS2_FD_OUTPUT_H
+#define COMP6771_ASS2_FD_OUTPUT_H
+
+#include "./filtered_string_view.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <ranges>
+#include <string_view>
+#include <system_error>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fsv {
+	namespace detail {
+		// gathers spans of characters into iovec batches written to a file descriptor with writev. spans given
+		// to add() are taken where they are, and must stay valid until the next flush(); only short ones are
+		// copied, into a staging buffer where adjacent ones merge into one iovec, so that many tiny runs do not
+		// use up the batch. copy() stages spans of any length, for blocks which do not stay valid.
+		class iovec_writer {
+#ifdef IOV_MAX
+			static constexpr auto max_spans = std::size_t{IOV_MAX < 1024 ? IOV_MAX : 1024};
+#else
+			static constexpr auto max_spans = std::size_t{16};
+#endif
+			static constexpr auto short_span = std::size_t{64};
+
+		 public:
+			explicit iovec_writer(int fd) noexcept
+			: fd_{fd} {}
+
+			iovec_writer(const iovec_writer&) = delete;
+			auto operator=(const iovec_writer&) -> iovec_writer& = delete;
+
+			auto add(const char* data, std::size_t size) -> void {
+				if (size < short_span) {
+					copy(data, size);
+					return;
+				}
+				if (count_ == spans_.size()) {
+					flush();
+				}
+				spans_[count_++] = {const_cast<char*>(data), size};
+			}
+
+			auto copy(const char* data, std::size_t size) -> void {
+				while (size != 0) {
+					if (staged_ == staging_.size() or (count_ == spans_.size() and not extends_last())) {
+						flush();
+					}
+					auto const count = std::min(size, staging_.size() - staged_);
+					auto* const out = staging_.data() + staged_;
+					std::memcpy(out, data, count);
+					if (extends_last()) {
+						spans_[count_ - 1].iov_len += count;
+					}
+					else {
+						spans_[count_++] = {out, count};
+					}
+					staged_ += count;
+					data += count;
+					size -= count;
+				}
+			}
+
+			// writes everything added so far, retrying partial writes. throws std::system_error if writev fails.
+			auto flush() -> void {
+				auto* iov = spans_.data();
+				auto left = count_;
+				while (left != 0) {
+					auto const n = ::writev(fd_, iov, static_cast<int>(left));
+					if (n == -1) {
+						if (errno == EINTR) {
+							continue;
+						}
+						throw std::system_error{errno, std::generic_category(), "write_to: writev"};
+					}
+					written_ += static_cast<std::size_t>(n);
+					// skips the spans written in full, then what was written of the next one
+					auto rest = static_cast<std::size_t>(n);
+					for (; left != 0 and rest >= iov->iov_len; ++iov, --left) {
+						rest -= iov->iov_len;
+					}
+					if (rest != 0) {
+						iov->iov_base = static_cast<char*>(iov->iov_base) + rest;
+						iov->iov_len -= rest;
+					}
+				}
+				count_ = 0;
+				staged_ = 0;
+			}
+
+			// bytes written so far
+			auto written() const noexcept -> std::size_t {
+				return written_;
+			}
+
+		 private:
+			int fd_;
+			std::array<::iovec, max_spans> spans_;
+			std::size_t count_ = 0;
+			std::array<char, 16 * 1024> staging_;
+			std::size_t staged_ = 0;
+			std::size_t written_ = 0;
+
+			// whether the last span ends where the next staged character goes
+			auto extends_last() const noexcept -> bool {
+				return count_ != 0
+				       and static_cast<const char*>(spans_[count_ - 1].iov_base) + spans_[count_ - 1].iov_len
+				               == staging_.data() + staged_;
+			}
+		};
+
+		// hands the kept characters of fsv to writer: the runs in place, or the blocks of the char_class
+		// kernels, which are faster to copy than the short runs a class tends to keep
+		template<char_predicate Pred>
+		auto add_kept(iovec_writer& writer, const basic_filtered_string_view<Pred>& fsv) -> void {
+			if (not fsv.has_runs() and char_class_of(fsv.predicate()) != nullptr) {
+				fsv.for_each_block([&writer](const char* kept, std::size_t count) { writer.copy(kept, count); });
+			}
+			else {
+				fsv.for_each_run([&writer](const char* run, std::size_t count) { writer.add(run, count); });
+			}
+		}
+	} // namespace detail
+
+	// writes the kept characters of fsv to the file descriptor fd without building a string: the runs of
+	// kept characters are handed to writev in place, up to IOV_MAX of them per call. returns the number of
+	// bytes written, which is fsv.size(). throws std::system_error if a write fails.
+	template<char_predicate Pred>
+	auto write_to(int fd, const basic_filtered_string_view<Pred>& fsv) -> std::size_t {
+		auto writer = detail::iovec_writer{fd};
+		detail::add_kept(writer, fsv);
+		writer.flush();
+		return writer.written();
+	}
+
+	// as above for every view in turn, each followed by separator (a newline ending each record, say), with
+	// the runs of all the views gathered into the same writev calls
+	template<std::ranges::input_range Views>
+	requires detail::is_filtered_view<std::ranges::range_value_t<Views>>
+	auto write_to(int fd, const Views& views, std::string_view separator = {}) -> std::size_t {
+		auto writer = detail::iovec_writer{fd};
+		for (auto const& view : views) {
+			detail::add_kept(writer, view);
+			if (not separator.empty()) {
+				writer.add(separator.data(), separator.size());
+			}
+		}
+		writer.flush();
+		return writer.written();
+	}
+} // namespace fsv
+
+#endif // COMP6771_ASS2_FD_OUTPUT_H
@@ -0,0 +1,92 @@
+#include "./fd_output.h"
+
+#include <array>
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+	// an anonymous temporary file, read back from the start
+	struct temp_fd {
+		temp_fd()
+		: file{std::tmpfile(), &std::fclose} {}
+
+		auto fd() const -> int {
+			return ::fileno(file.get());
+		}
+
+		auto contents() const -> std::string {
+			auto str = std::string{};
+			auto buffer = std::array<char, 4096>{};
+			::lseek(fd(), 0, SEEK_SET);
+			while (true) {
+				auto const n = ::read(fd(), buffer.data(), buffer.size());
+				if (n <= 0) {
+					return str;
+				}
+				str.append(buffer.data(), static_cast<std::size_t>(n));
+			}
+		}
+
+		std::unique_ptr<std::FILE, decltype(&std::fclose)> file;
+	};
+} // namespace
+
+TEST_CASE("write_to a file descriptor") {
+	auto const printable = [](const char& c) { return c >= ' '; };
+	auto str = std::string{};
+	for (auto i = 0; i < 20000; ++i) {
+		// short and long runs, so that spans are both staged and taken in place
+		str.append(i % 7 == 0 ? std::string(100, 'x') : std::to_string(i)).append(i % 3 == 0 ? "\r\n" : "\t");
+	}
+
+	SECTION("writes the kept characters, across many writev batches") {
+		auto const sv = fsv::filtered_string_view{str, printable};
+		auto const out = temp_fd{};
+		CHECK(fsv::write_to(out.fd(), sv) == sv.size());
+		CHECK(out.contents() == static_cast<std::string>(sv));
+	}
+
+	SECTION("with a char_class, runs or nothing filtered out") {
+		auto const digits = fsv::basic_filtered_string_view{str, fsv::char_class::digits()};
+		auto const digits_out = temp_fd{};
+		fsv::write_to(digits_out.fd(), digits);
+		CHECK(digits_out.contents() == static_cast<std::string>(digits));
+
+		auto const runs = fsv::filtered_string_view{str, printable}.with_runs();
+		auto const runs_out = temp_fd{};
+		fsv::write_to(runs_out.fd(), runs);
+		CHECK(runs_out.contents() == static_cast<std::string>(runs));
+
+		auto const all_out = temp_fd{};
+		CHECK(fsv::write_to(all_out.fd(), fsv::filtered_string_view{str}) == str.size());
+		CHECK(all_out.contents() == str);
+	}
+
+	SECTION("many views with a separator") {
+		auto const records = fsv::split(fsv::filtered_string_view{str, [](const char& c) { return c != '\r'; }},
+		                                fsv::filtered_string_view{"\n"});
+		auto expected = std::string{};
+		for (auto const& record : records) {
+			expected.append(static_cast<std::string>(record)).append("\n");
+		}
+		auto const out = temp_fd{};
+		CHECK(fsv::write_to(out.fd(), records, "\n") == expected.size());
+		CHECK(out.contents() == expected);
+	}
+
+	SECTION("an empty view writes nothing") {
+		auto const out = temp_fd{};
+		CHECK(fsv::write_to(out.fd(), fsv::filtered_string_view{"\n\n", printable}) == 0);
+		CHECK(out.contents().empty());
+	}
+
+	SECTION("a bad descriptor throws") {
+		CHECK_THROWS_AS(fsv::write_to(-1, fsv::filtered_string_view{"abc"}), std::system_error);
+	}
+}
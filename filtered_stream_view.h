@@ -0,0 +1,346 @@
+#ifndef COMP6771_ASS2_FSTREAMV_H
+#define COMP6771_ASS2_FSTREAMV_H
+
+#include "./filtered_string_view.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fsv {
+	// a source of input in chunks: fills the front of the buffer and returns how many characters it wrote,
+	// or 0 at the end of the input
+	using chunk_source = std::function<std::size_t(std::span<char> buffer)>;
+
+	template<char_predicate Pred = filter>
+	class basic_filtered_stream_view;
+
+	template<char_predicate Pred>
+	class stream_split_view;
+
+	using filtered_stream_view = basic_filtered_stream_view<filter>;
+
+	namespace detail {
+		// moves the characters of [str, str + length) kept by pred to the front, returning how many there are
+		template<char_predicate Pred>
+		auto compact_kept(char* str, std::size_t length, const Pred& pred) -> std::size_t {
+			if (keeps_everything(pred)) {
+				return length;
+			}
+			if (auto const* cls = char_class_of(pred)) {
+				// the kernels never write past the character they are reading, so they can work in place
+				return compress_kept(str, length, *cls, str);
+			}
+			auto kept = std::size_t{0};
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				if (pred(str[i])) {
+					str[kept++] = str[i];
+				}
+			}
+			return kept;
+		}
+	} // namespace detail
+
+	// a single-pass view of the characters kept by Pred from a stream or a chunk source. input is read one
+	// buffer at a time and filtered in place, so memory stays bounded by the buffer whatever the length of
+	// the input. the view owns its buffer and cannot be copied; its iterators refer to it and are input
+	// iterators: reading a character consumes it.
+	template<char_predicate Pred>
+	class basic_filtered_stream_view {
+		class iter {
+		 public:
+			using iterator_concept = std::input_iterator_tag;
+			using value_type = char;
+			using reference = const char&;
+			using difference_type = std::ptrdiff_t;
+
+			iter() noexcept = default;
+
+			auto operator*() const -> reference {
+				return view_->buffer_[view_->first_];
+			}
+
+			auto operator++() -> iter& {
+				view_->advance();
+				return *this;
+			}
+
+			auto operator++(int) -> void {
+				++*this;
+			}
+
+			friend auto operator==(const iter& it, std::default_sentinel_t) noexcept -> bool {
+				return it.at_end();
+			}
+
+		 private:
+			explicit iter(basic_filtered_stream_view* view) noexcept
+			: view_{view} {}
+
+			auto at_end() const noexcept -> bool {
+				return view_->first_ == view_->last_;
+			}
+
+			basic_filtered_stream_view* view_ = nullptr;
+
+			friend class basic_filtered_stream_view;
+		};
+
+	 public:
+		using predicate_type = Pred;
+		using iterator = iter;
+
+		static constexpr auto default_capacity = std::size_t{64 * 1024};
+
+		explicit basic_filtered_stream_view(std::istream& is, std::size_t capacity = default_capacity)
+		requires std::constructible_from<Pred, true_predicate>
+		: basic_filtered_stream_view{is, Pred{true_predicate{}}, capacity} {}
+
+		basic_filtered_stream_view(std::istream& is, Pred predicate, std::size_t capacity = default_capacity)
+		: basic_filtered_stream_view{chunk_source{[&is](std::span<char> buffer) {
+			                             is.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			                             return static_cast<std::size_t>(is.gcount());
+		                             }},
+		                             std::move(predicate),
+		                             capacity} {}
+
+		explicit basic_filtered_stream_view(chunk_source source, std::size_t capacity = default_capacity)
+		requires std::constructible_from<Pred, true_predicate>
+		: basic_filtered_stream_view{std::move(source), Pred{true_predicate{}}, capacity} {}
+
+		basic_filtered_stream_view(chunk_source source, Pred predicate, std::size_t capacity = default_capacity)
+		: source_{std::move(source)}
+		, predicate_{std::move(predicate)}
+		, capacity_{std::max(capacity, std::size_t{1})}
+		, buffer_{std::make_unique<char[]>(capacity_)} {}
+
+		basic_filtered_stream_view(const basic_filtered_stream_view&) = delete;
+		auto operator=(const basic_filtered_stream_view&) -> basic_filtered_stream_view& = delete;
+
+		// moving invalidates the iterators of both views
+		basic_filtered_stream_view(basic_filtered_stream_view&&) noexcept = default;
+		auto operator=(basic_filtered_stream_view&&) noexcept -> basic_filtered_stream_view& = default;
+
+		~basic_filtered_stream_view() noexcept = default;
+
+		// reads the first chunk if nothing is buffered yet
+		auto begin() -> iterator {
+			if (first_ == last_) {
+				refill();
+			}
+			return iterator{this};
+		}
+
+		auto end() const noexcept -> std::default_sentinel_t {
+			return std::default_sentinel;
+		}
+
+		auto predicate() const noexcept -> const Pred& {
+			return predicate_.get();
+		}
+
+		// writes every remaining kept character to os, a buffer at a time
+		friend auto operator<<(std::ostream& os, basic_filtered_stream_view& fsv) -> std::ostream& {
+			fsv.drain([&os](const char* kept, std::size_t count) {
+				os.write(kept, static_cast<std::streamsize>(count));
+			});
+			return os;
+		}
+
+		friend auto operator<<(std::ostream& os, basic_filtered_stream_view&& fsv) -> std::ostream& {
+			return os << fsv;
+		}
+
+	 private:
+		chunk_source source_;
+		detail::predicate_box<Pred> predicate_;
+		std::size_t capacity_;
+		std::unique_ptr<char[]> buffer_;
+		// the unread kept characters are buffer_[first_, last_)
+		std::size_t first_ = 0;
+		std::size_t last_ = 0;
+		bool eof_ = false;
+
+		// reads and filters chunks until one keeps something or the input ends
+		auto refill() -> void {
+			first_ = 0;
+			last_ = 0;
+			while (not eof_ and last_ == 0) {
+				auto const read = std::min(source_(std::span<char>{buffer_.get(), capacity_}), capacity_);
+				eof_ = read == 0;
+				last_ = detail::compact_kept(buffer_.get(), read, predicate_.get());
+			}
+		}
+
+		auto advance() -> void {
+			if (++first_ == last_) {
+				refill();
+			}
+		}
+
+		// calls fn(kept, count) with the rest of the input
+		template<typename Fn>
+		auto drain(Fn fn) -> void {
+			for (begin(); first_ != last_; refill()) {
+				fn(static_cast<const char*>(buffer_.get() + first_), last_ - first_);
+			}
+		}
+
+		// appends the kept characters up to the next occurrence of needle to out, consuming the needle too.
+		// the match is tracked with the Knuth-Morris-Pratt failure table of needle, so it may straddle any
+		// number of chunks. returns false if the input ends first.
+		auto read_until(std::string& out, std::string_view needle, std::span<const std::size_t> failure) -> bool {
+			auto matched = std::size_t{0};
+			for (begin(); first_ != last_; refill()) {
+				auto const start = first_;
+				while (first_ != last_) {
+					auto const c = buffer_[first_++];
+					while (matched > 0 and c != needle[matched]) {
+						matched = failure[matched - 1];
+					}
+					if (c == needle[matched] and ++matched == needle.size()) {
+						out.append(buffer_.get() + start, first_ - start);
+						out.resize(out.size() - needle.size());
+						if (first_ == last_) {
+							refill();
+						}
+						return true;
+					}
+				}
+				out.append(buffer_.get() + start, last_ - start);
+			}
+			return false;
+		}
+
+		template<char_predicate>
+		friend class stream_split_view;
+	};
+
+	template<char_predicate Pred>
+	basic_filtered_stream_view(std::istream&, Pred) -> basic_filtered_stream_view<Pred>;
+
+	template<char_predicate Pred>
+	basic_filtered_stream_view(std::istream&, Pred, std::size_t) -> basic_filtered_stream_view<Pred>;
+
+	template<char_predicate Pred>
+	basic_filtered_stream_view(chunk_source, Pred) -> basic_filtered_stream_view<Pred>;
+
+	template<char_predicate Pred>
+	basic_filtered_stream_view(chunk_source, Pred, std::size_t) -> basic_filtered_stream_view<Pred>;
+
+	// the pieces of a stream view split on a token, as owning strings, since a piece may span several
+	// chunks. pieces are read when an iterator reaches them and follow the rules of split() on a
+	// filtered_string_view: n tokens make n + 1 pieces, any of which may be empty.
+	template<char_predicate Pred>
+	class stream_split_view : public std::ranges::view_interface<stream_split_view<Pred>> {
+		class iter {
+		 public:
+			using iterator_concept = std::input_iterator_tag;
+			using value_type = std::string;
+			using reference = const std::string&;
+			using difference_type = std::ptrdiff_t;
+
+			iter() noexcept = default;
+
+			auto operator*() const -> reference {
+				return parent_->piece_;
+			}
+
+			auto operator++() -> iter& {
+				parent_->next_piece();
+				return *this;
+			}
+
+			auto operator++(int) -> void {
+				++*this;
+			}
+
+			friend auto operator==(const iter& it, std::default_sentinel_t) noexcept -> bool {
+				return it.at_end();
+			}
+
+		 private:
+			explicit iter(stream_split_view* parent) noexcept
+			: parent_{parent} {}
+
+			auto at_end() const noexcept -> bool {
+				return parent_->done_;
+			}
+
+			stream_split_view* parent_ = nullptr;
+
+			friend class stream_split_view;
+		};
+
+	 public:
+		template<char_predicate TokPred>
+		stream_split_view(basic_filtered_stream_view<Pred>& stream, const basic_filtered_string_view<TokPred>& tok)
+		: stream_split_view{stream, static_cast<std::string>(tok)} {}
+
+		// splits on the characters of needle, which is not filtered
+		stream_split_view(basic_filtered_stream_view<Pred>& stream, std::string needle)
+		: stream_{&stream}
+		, needle_{std::move(needle)}
+		, failure_(needle_.size()) {
+			// failure_[i] is the length of the longest proper border of needle_[0, i]
+			for (auto i = std::size_t{1}, k = std::size_t{0}; i < needle_.size(); ++i) {
+				while (k > 0 and needle_[i] != needle_[k]) {
+					k = failure_[k - 1];
+				}
+				if (needle_[i] == needle_[k]) {
+					++k;
+				}
+				failure_[i] = k;
+			}
+		}
+
+		// reads the first piece; like the stream it is single pass, so it must be called once
+		auto begin() -> iter {
+			next_piece();
+			return iter{this};
+		}
+
+		auto end() const noexcept -> std::default_sentinel_t {
+			return std::default_sentinel;
+		}
+
+	 private:
+		auto next_piece() -> void {
+			if (last_piece_) {
+				done_ = true;
+				return;
+			}
+			piece_.clear();
+			if (needle_.empty()) {
+				stream_->drain([this](const char* kept, std::size_t count) { piece_.append(kept, count); });
+				last_piece_ = true;
+				return;
+			}
+			last_piece_ = not stream_->read_until(piece_, needle_, failure_);
+		}
+
+		basic_filtered_stream_view<Pred>* stream_;
+		std::string needle_;
+		std::vector<std::size_t> failure_;
+		std::string piece_;
+		bool last_piece_ = false;
+		bool done_ = false;
+	};
+
+	template<char_predicate Pred, char_predicate TokPred>
+	auto split(basic_filtered_stream_view<Pred>& stream, const basic_filtered_string_view<TokPred>& tok)
+	    -> stream_split_view<Pred> {
+		return stream_split_view<Pred>{stream, tok};
+	}
+} // namespace fsv
+
+#endif // COMP6771_ASS2_FSTREAMV_H
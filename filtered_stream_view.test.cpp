@@ -0,0 +1,109 @@
+#include "./filtered_stream_view.h"
+
+#include <catch2/catch.hpp>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	template<typename Stream>
+	auto read_all(Stream& stream) -> std::string {
+		auto str = std::string{};
+		for (auto const c : stream) {
+			str.push_back(c);
+		}
+		return str;
+	}
+} // namespace
+
+TEST_CASE("filtered_stream_view") {
+	auto const text = std::string{"the quick::brown fox:: jumps over:::the lazy dog::"};
+	auto const no_spaces = [](const char& c) { return c != ' '; };
+
+	SECTION("iterating reads the kept characters across chunks") {
+		auto is = std::istringstream{text};
+		auto stream = fsv::filtered_stream_view{is, no_spaces, 3};
+		CHECK(read_all(stream) == static_cast<std::string>(fsv::filtered_string_view{text, no_spaces}));
+	}
+
+	SECTION("without a predicate every character is kept") {
+		auto is = std::istringstream{text};
+		auto stream = fsv::filtered_stream_view{is, 4};
+		CHECK(read_all(stream) == text);
+	}
+
+	SECTION("a chunk source may return fewer characters than asked for") {
+		auto offset = std::size_t{0};
+		auto stream = fsv::basic_filtered_stream_view{[&](std::span<char> buffer) {
+			                                              auto const n = std::min({buffer.size(), text.size() - offset, std::size_t{2}});
+			                                              std::copy_n(text.data() + offset, n, buffer.data());
+			                                              offset += n;
+			                                              return n;
+		                                              },
+		                                              fsv::char_class::alpha()};
+		auto os = std::ostringstream{};
+		os << stream;
+		CHECK(os.str() == "thequickbrownfoxjumpsoverthelazydog");
+		CHECK(stream.begin() == stream.end());
+	}
+
+	SECTION("chunks where nothing is kept are skipped") {
+		auto is = std::istringstream{"      a      b"};
+		auto stream = fsv::filtered_stream_view{is, no_spaces, 2};
+		CHECK(read_all(stream) == "ab");
+	}
+
+	SECTION("empty input") {
+		auto is = std::istringstream{};
+		auto stream = fsv::filtered_stream_view{is};
+		CHECK(stream.begin() == stream.end());
+	}
+
+	SECTION("split finds tokens which straddle chunks") {
+		for (auto const capacity : {std::size_t{1}, std::size_t{2}, std::size_t{5}, std::size_t{64}}) {
+			auto is = std::istringstream{text};
+			auto stream = fsv::filtered_stream_view{is, no_spaces, capacity};
+			auto pieces = std::vector<std::string>{};
+			for (auto const& piece : fsv::split(stream, fsv::filtered_string_view{"::"})) {
+				pieces.push_back(piece);
+			}
+
+			auto expected = std::vector<std::string>{};
+			for (auto const& piece : fsv::split(fsv::filtered_string_view{text, no_spaces}, fsv::filtered_string_view{"::"})) {
+				expected.push_back(static_cast<std::string>(piece));
+			}
+			CHECK(pieces == expected);
+			CHECK(pieces == std::vector<std::string>{"thequick", "brownfox", "jumpsover", ":thelazydog", ""});
+		}
+	}
+
+	SECTION("split on a token with a repeated prefix") {
+		auto is = std::istringstream{"aabaabaaab"};
+		auto stream = fsv::filtered_stream_view{is, 3};
+		auto pieces = std::vector<std::string>{};
+		for (auto const& piece : fsv::split(stream, fsv::filtered_string_view{"aab"})) {
+			pieces.push_back(piece);
+		}
+		CHECK(pieces == std::vector<std::string>{"", "", "a", ""});
+	}
+
+	SECTION("split with an empty token or on empty input makes one piece") {
+		auto is = std::istringstream{text};
+		auto stream = fsv::filtered_stream_view{is, 7};
+		auto pieces = std::vector<std::string>{};
+		for (auto const& piece : fsv::split(stream, fsv::filtered_string_view{""})) {
+			pieces.push_back(piece);
+		}
+		CHECK(pieces == std::vector<std::string>{text});
+
+		auto empty = std::istringstream{};
+		auto empty_stream = fsv::filtered_stream_view{empty};
+		auto count = 0;
+		for (auto const& piece : fsv::split(empty_stream, fsv::filtered_string_view{","})) {
+			CHECK(piece.empty());
+			++count;
+		}
+		CHECK(count == 1);
+	}
+}
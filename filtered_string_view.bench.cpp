@@ -0,0 +1,560 @@
+#include "./fd_output.h"
+#include "./filtered_string_view.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+	// input sizes run from 16 B to 1 GiB in steps of 64x
+	constexpr auto min_size = std::int64_t{16};
+	constexpr auto max_size = std::int64_t{1} << 30;
+	constexpr auto size_step = 64;
+
+	// log-like text: letters, digits, punctuation and separators from a fixed seed
+	auto make_input(std::size_t size) -> std::string {
+		constexpr auto alphabet = std::string_view{"abcdefghijklmnopqrstuvwxyzABCDEF0123456789 ,.:-\t"};
+		auto str = std::string(size, ' ');
+		auto state = std::uint32_t{12345};
+		for (auto& c : str) {
+			state = state * 1664525u + 1013904223u;
+			c = alphabet[(state >> 16) % alphabet.size()];
+		}
+		return str;
+	}
+
+	// the predicate kinds worth telling apart: the default, a char_class the kernels recognise and
+	// an opaque lambda that has to be called per character
+	struct keep_all {
+		static auto make() -> fsv::filter {
+			return fsv::true_predicate{};
+		}
+	};
+
+	struct alnum_class {
+		static auto make() -> fsv::filter {
+			return fsv::char_class::alnum();
+		}
+	};
+
+	struct capturing_lambda {
+		static auto make() -> fsv::filter {
+			auto table = std::array<bool, 256>{};
+			for (auto c = 0; c < 256; ++c) {
+				table[static_cast<std::size_t>(c)] = fsv::char_class::alnum()(static_cast<char>(c));
+			}
+			return [table](const char& c) { return table[static_cast<unsigned char>(c)]; };
+		}
+	};
+
+	// drops only the control characters (tabs, here), so it keeps long runs
+	struct printable_lambda {
+		static auto make() -> fsv::filter {
+			return [](const char& c) { return static_cast<unsigned char>(c) >= ' '; };
+		}
+	};
+
+	void set_bytes(benchmark::State& state, std::size_t bytes) {
+		state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+	}
+
+	// a predicate capturing Bytes of state, so that copying it by value would copy that much
+	template<std::size_t Bytes>
+	auto capturing_predicate() {
+		auto table = std::array<char, Bytes>{};
+		table.fill('x');
+		return [table](const char& c) { return c != table[0]; };
+	}
+
+	template<std::size_t Bytes>
+	void bm_copy_view(benchmark::State& state) {
+		auto const str = std::string(64, 'a');
+		auto const sv = fsv::filtered_string_view{str, capturing_predicate<Bytes>()};
+		for (auto _ : state) {
+			auto copy = sv;
+			benchmark::DoNotOptimize(copy);
+		}
+	}
+
+	template<std::size_t Bytes>
+	void bm_copy_iterator(benchmark::State& state) {
+		auto const str = std::string(64, 'a');
+		auto const sv = fsv::filtered_string_view{str, capturing_predicate<Bytes>()};
+		auto const it = sv.begin();
+		for (auto _ : state) {
+			auto copy = it;
+			benchmark::DoNotOptimize(copy);
+		}
+	}
+
+	// construction from a C string pays for the strlen
+	void bm_construct_cstr(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		for (auto _ : state) {
+			auto sv = fsv::filtered_string_view{str.c_str()};
+			benchmark::DoNotOptimize(sv);
+		}
+		set_bytes(state, str.size());
+	}
+
+	// construction from a pointer and a length does not look at the characters
+	void bm_construct_sized(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		for (auto _ : state) {
+			auto sv = fsv::filtered_string_view{str.data(), str.size()};
+			benchmark::DoNotOptimize(sv);
+		}
+		set_bytes(state, str.size());
+	}
+
+	// a fresh view each iteration, so the memoized length is never reused
+	template<typename Kind>
+	void bm_size(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const pred = Kind::make();
+		for (auto _ : state) {
+			auto const sv = fsv::filtered_string_view{str, pred};
+			benchmark::DoNotOptimize(sv.size());
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_subscript(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const size = sv.size();
+		if (size == 0) {
+			state.SkipWithError("nothing kept");
+			return;
+		}
+		auto i = std::size_t{0};
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(sv[static_cast<int>(i)]);
+			i = (i + 7919) % size;
+		}
+	}
+
+	template<typename Kind>
+	void bm_subscript_indexed(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()}.with_index();
+		auto const size = sv.size();
+		if (size == 0) {
+			state.SkipWithError("nothing kept");
+			return;
+		}
+		auto i = std::size_t{0};
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(sv[static_cast<int>(i)]);
+			i = (i + 7919) % size;
+		}
+	}
+
+	template<typename Kind>
+	void bm_iterate_forward(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		for (auto _ : state) {
+			auto sum = 0u;
+			for (auto const c : sv) {
+				sum += static_cast<unsigned char>(c);
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_iterate_reverse(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		for (auto _ : state) {
+			auto sum = 0u;
+			for (auto it = sv.rbegin(); it != sv.rend(); ++it) {
+				sum += static_cast<unsigned char>(*it);
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		set_bytes(state, str.size());
+	}
+
+	// equal views are the worst case: every kept character is looked at. rhs views a copy of the input, as
+	// views over the same characters with the same predicate compare equal without looking at any
+	template<typename Kind>
+	void bm_compare(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const copy = str;
+		auto const lhs = fsv::filtered_string_view{str, Kind::make()};
+		auto const rhs = fsv::filtered_string_view{copy, Kind::make()};
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(lhs <=> rhs);
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_hash(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(fsv::hash{}(sv));
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_split(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const tok = fsv::filtered_string_view{"a"};
+		for (auto _ : state) {
+			auto pieces = fsv::split(sv, tok);
+			benchmark::DoNotOptimize(pieces.data());
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_substr(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const size = static_cast<int>(sv.size());
+		for (auto _ : state) {
+			auto sub = fsv::substr(sv, size / 4, size / 2);
+			benchmark::DoNotOptimize(sub.size());
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_to_string(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		for (auto _ : state) {
+			auto const filtered = static_cast<std::string>(sv);
+			benchmark::DoNotOptimize(filtered.data());
+		}
+		set_bytes(state, str.size());
+	}
+
+	// the same with the runs found once up front, so that each conversion copies a run at a time
+	template<typename Kind>
+	void bm_to_string_runs(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()}.with_runs();
+		benchmark::DoNotOptimize(sv.size());
+		for (auto _ : state) {
+			auto const filtered = static_cast<std::string>(sv);
+			benchmark::DoNotOptimize(filtered.data());
+		}
+		set_bytes(state, str.size());
+	}
+
+	// writing to /dev/null through a string, for comparison with bm_write_to_fd
+	template<typename Kind>
+	void bm_write_string_fd(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+		for (auto _ : state) {
+			auto const filtered = static_cast<std::string>(sv);
+			benchmark::DoNotOptimize(::write(fd, filtered.data(), filtered.size()));
+		}
+		::close(fd);
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_write_to_fd(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(fsv::write_to(fd, sv));
+		}
+		::close(fd);
+		set_bytes(state, str.size());
+	}
+
+	// a CSV row of numbers padded with spaces
+	auto make_number_row() -> std::string {
+		auto str = std::string{};
+		auto state = std::uint32_t{12345};
+		for (auto i = 0; i < 4096; ++i) {
+			state = state * 1664525u + 1013904223u;
+			str.append(" ").append(std::to_string(static_cast<int>(state >> 8) - (1 << 23))).append(" ,");
+		}
+		return str;
+	}
+
+	// the fields of row, with the spaces filtered out
+	auto number_fields(const std::string& row) -> std::vector<fsv::filtered_string_view> {
+		return fsv::split(fsv::filtered_string_view{row, [](const char& c) { return c != ' '; }},
+		                  fsv::filtered_string_view{","});
+	}
+
+	// parsing every field through a string, for comparison with bm_parse_from_chars
+	void bm_parse_stoi(benchmark::State& state) {
+		auto const row = make_number_row();
+		auto const fields = number_fields(row);
+		for (auto _ : state) {
+			auto sum = 0l;
+			for (auto i = std::size_t{0}; i + 1 < fields.size(); ++i) {
+				sum += std::stoi(static_cast<std::string>(fields[i]));
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * (fields.size() - 1)));
+	}
+
+	void bm_parse_from_chars(benchmark::State& state) {
+		auto const row = make_number_row();
+		auto const fields = number_fields(row);
+		for (auto _ : state) {
+			auto sum = 0l;
+			for (auto i = std::size_t{0}; i + 1 < fields.size(); ++i) {
+				auto n = 0;
+				fsv::from_chars(fields[i], n);
+				sum += n;
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * (fields.size() - 1)));
+	}
+
+	// keywords of 3 to 8 characters from the input's alphabet, most of which turn up now and then
+	auto make_keywords(std::size_t count) -> std::vector<std::string> {
+		constexpr auto alphabet = std::string_view{"abcdefghijklmnopqrstuvwxyzABCDEF0123456789"};
+		auto keywords = std::vector<std::string>{};
+		auto state = std::uint32_t{54321};
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			state = state * 1664525u + 1013904223u;
+			auto& keyword = keywords.emplace_back(3 + (state >> 16) % 6, ' ');
+			for (auto& c : keyword) {
+				state = state * 1664525u + 1013904223u;
+				c = alphabet[(state >> 16) % alphabet.size()];
+			}
+		}
+		return keywords;
+	}
+
+	// every occurrence of range(1) keywords, one find() after another, for comparison with bm_multi_match
+	template<typename Kind>
+	void bm_repeated_find(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const keywords = make_keywords(static_cast<std::size_t>(state.range(1)));
+		for (auto _ : state) {
+			auto found = std::size_t{0};
+			for (auto const& keyword : keywords) {
+				for (auto pos = sv.find(keyword); pos != sv.npos; pos = sv.find(keyword, pos + 1)) {
+					++found;
+				}
+			}
+			benchmark::DoNotOptimize(found);
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_multi_match(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const matcher = fsv::multi_matcher{make_keywords(static_cast<std::size_t>(state.range(1)))};
+		for (auto _ : state) {
+			auto found = std::size_t{0};
+			matcher.for_each_match(sv, [&found](const fsv::pattern_match<fsv::filter>&) { ++found; });
+			benchmark::DoNotOptimize(found);
+		}
+		set_bytes(state, str.size());
+	}
+
+	// sorting the pieces of split() with operator<, for comparison with bm_sort
+	template<typename Kind>
+	void bm_std_sort(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const pieces = fsv::split(fsv::filtered_string_view{str, Kind::make()}, fsv::filtered_string_view{"a"});
+		for (auto _ : state) {
+			state.PauseTiming();
+			auto views = pieces;
+			state.ResumeTiming();
+			std::ranges::sort(views);
+			benchmark::DoNotOptimize(views.data());
+		}
+		state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * pieces.size()));
+	}
+
+	template<typename Kind>
+	void bm_sort(benchmark::State& state) {
+		auto const str = make_input(static_cast<std::size_t>(state.range(0)));
+		auto const pieces = fsv::split(fsv::filtered_string_view{str, Kind::make()}, fsv::filtered_string_view{"a"});
+		for (auto _ : state) {
+			state.PauseTiming();
+			auto views = pieces;
+			state.ResumeTiming();
+			fsv::sort(views);
+			benchmark::DoNotOptimize(views.data());
+		}
+		state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * pieces.size()));
+	}
+
+	// chains of opaque lambdas that cannot be fused, walked end to end
+	void bm_compose_lambdas(benchmark::State& state) {
+		auto const str = make_input(std::size_t{1} << 16);
+		auto const sv = fsv::filtered_string_view{str};
+		auto filts = std::vector<fsv::filter>{};
+		for (auto i = 0; i < state.range(0); ++i) {
+			auto const skip = static_cast<char>('A' + i);
+			filts.emplace_back([skip](const char& c) { return c != skip; });
+		}
+		auto const composed = fsv::compose(sv, filts);
+		for (auto _ : state) {
+			auto sum = 0u;
+			for (auto const c : composed) {
+				sum += static_cast<unsigned char>(c);
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		set_bytes(state, str.size());
+	}
+
+	// chains of char_class filters, which compose fuses into a single table
+	void bm_compose_classes(benchmark::State& state) {
+		auto const str = make_input(std::size_t{1} << 16);
+		auto const sv = fsv::filtered_string_view{str};
+		auto filts = std::vector<fsv::filter>{};
+		for (auto i = 0; i < state.range(0); ++i) {
+			filts.emplace_back(~fsv::char_class{std::string_view{"ABCDEFGHIJKLMNOP"}.substr(static_cast<std::size_t>(i), 1)});
+		}
+		auto const composed = fsv::compose(sv, filts);
+		for (auto _ : state) {
+			auto sum = 0u;
+			for (auto const c : composed) {
+				sum += static_cast<unsigned char>(c);
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		set_bytes(state, str.size());
+	}
+
+	// 256 MiB shared by the parallel benchmarks, which only vary the thread count
+	auto parallel_input() -> const std::string& {
+		static auto const str = make_input(std::size_t{1} << 28);
+		return str;
+	}
+
+	// thread counts doubling up to the number of hardware threads, and that number itself
+	void thread_counts(benchmark::internal::Benchmark* bm) {
+		auto const hardware = static_cast<std::int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+		for (auto threads = std::int64_t{1}; threads < hardware; threads *= 2) {
+			bm->Arg(threads);
+		}
+		bm->Arg(hardware);
+	}
+
+	template<typename Kind>
+	void bm_parallel_size(benchmark::State& state) {
+		auto const& str = parallel_input();
+		auto const pred = Kind::make();
+		auto const policy = fsv::parallel{.threads = static_cast<std::size_t>(state.range(0))};
+		for (auto _ : state) {
+			auto const sv = fsv::filtered_string_view{str, pred};
+			benchmark::DoNotOptimize(fsv::size(policy, sv));
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_parallel_to_string(benchmark::State& state) {
+		auto const& str = parallel_input();
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const policy = fsv::parallel{.threads = static_cast<std::size_t>(state.range(0))};
+		for (auto _ : state) {
+			auto const filtered = fsv::to_string(policy, sv);
+			benchmark::DoNotOptimize(filtered.data());
+		}
+		set_bytes(state, str.size());
+	}
+
+	template<typename Kind>
+	void bm_parallel_split(benchmark::State& state) {
+		auto const& str = parallel_input();
+		auto const sv = fsv::filtered_string_view{str, Kind::make()};
+		auto const tok = fsv::filtered_string_view{"a"};
+		auto const policy = fsv::parallel{.threads = static_cast<std::size_t>(state.range(0))};
+		for (auto _ : state) {
+			auto pieces = fsv::split(policy, sv, tok);
+			benchmark::DoNotOptimize(pieces.data());
+		}
+		set_bytes(state, str.size());
+	}
+} // namespace
+
+#define FSV_BENCHMARK_SIZES(...) \
+	BENCHMARK_TEMPLATE(__VA_ARGS__)->RangeMultiplier(size_step)->Range(min_size, max_size)
+
+#define FSV_BENCHMARK_KINDS(bm) \
+	FSV_BENCHMARK_SIZES(bm, keep_all); \
+	FSV_BENCHMARK_SIZES(bm, alnum_class); \
+	FSV_BENCHMARK_SIZES(bm, capturing_lambda)
+
+// copying a view or an iterator costs the same whatever the predicate captures
+BENCHMARK_TEMPLATE(bm_copy_view, 8);
+BENCHMARK_TEMPLATE(bm_copy_view, 64);
+BENCHMARK_TEMPLATE(bm_copy_view, 512);
+BENCHMARK_TEMPLATE(bm_copy_view, 4096);
+BENCHMARK_TEMPLATE(bm_copy_iterator, 8);
+BENCHMARK_TEMPLATE(bm_copy_iterator, 64);
+BENCHMARK_TEMPLATE(bm_copy_iterator, 512);
+BENCHMARK_TEMPLATE(bm_copy_iterator, 4096);
+
+BENCHMARK(bm_construct_cstr)->RangeMultiplier(size_step)->Range(min_size, max_size);
+BENCHMARK(bm_construct_sized)->RangeMultiplier(size_step)->Range(min_size, max_size);
+FSV_BENCHMARK_KINDS(bm_size);
+FSV_BENCHMARK_KINDS(bm_subscript);
+FSV_BENCHMARK_KINDS(bm_subscript_indexed);
+FSV_BENCHMARK_KINDS(bm_iterate_forward);
+FSV_BENCHMARK_KINDS(bm_iterate_reverse);
+FSV_BENCHMARK_KINDS(bm_compare);
+FSV_BENCHMARK_KINDS(bm_hash);
+FSV_BENCHMARK_KINDS(bm_split);
+FSV_BENCHMARK_KINDS(bm_substr);
+FSV_BENCHMARK_KINDS(bm_to_string);
+FSV_BENCHMARK_SIZES(bm_to_string, printable_lambda);
+FSV_BENCHMARK_SIZES(bm_to_string_runs, capturing_lambda);
+FSV_BENCHMARK_SIZES(bm_to_string_runs, printable_lambda);
+FSV_BENCHMARK_KINDS(bm_write_string_fd);
+FSV_BENCHMARK_SIZES(bm_write_string_fd, printable_lambda);
+FSV_BENCHMARK_KINDS(bm_write_to_fd);
+FSV_BENCHMARK_SIZES(bm_write_to_fd, printable_lambda);
+BENCHMARK_TEMPLATE(bm_repeated_find, alnum_class)->ArgsProduct({{1 << 16, 1 << 20}, {10, 100, 500}});
+BENCHMARK_TEMPLATE(bm_multi_match, alnum_class)->ArgsProduct({{1 << 16, 1 << 20}, {10, 100, 500}});
+BENCHMARK(bm_parse_stoi);
+BENCHMARK(bm_parse_from_chars);
+BENCHMARK_TEMPLATE(bm_std_sort, alnum_class)->Range(1 << 16, 1 << 22);
+BENCHMARK_TEMPLATE(bm_std_sort, capturing_lambda)->Range(1 << 16, 1 << 22);
+BENCHMARK_TEMPLATE(bm_sort, alnum_class)->Range(1 << 16, 1 << 22);
+BENCHMARK_TEMPLATE(bm_sort, capturing_lambda)->Range(1 << 16, 1 << 22);
+BENCHMARK(bm_compose_lambdas)->DenseRange(1, 16);
+BENCHMARK(bm_compose_classes)->DenseRange(1, 16);
+
+// these should scale close to linearly up to the number of cores
+#define FSV_BENCHMARK_THREADS(bm) \
+	BENCHMARK_TEMPLATE(bm, alnum_class)->Apply(thread_counts)->UseRealTime(); \
+	BENCHMARK_TEMPLATE(bm, capturing_lambda)->Apply(thread_counts)->UseRealTime()
+
+FSV_BENCHMARK_THREADS(bm_parallel_size);
+FSV_BENCHMARK_THREADS(bm_parallel_to_string);
+FSV_BENCHMARK_THREADS(bm_parallel_split);
+
+BENCHMARK_MAIN();
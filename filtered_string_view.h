@@ -2,18 +2,1257 @@
 #define COMP6771_ASS2_FSV_H
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
 #include <compare>
+#include <concepts>
+#include <cstdint>
 #include <cstring>
+#include <exception>
 #include <functional>
+#include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <ostream>
+#include <ranges>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#if (defined(__x86_64__) or defined(__i386__)) and (defined(__GNUC__) or defined(__clang__))
+#include <immintrin.h>
+#define FSV_HAS_AVX2_KERNELS 1
+#endif
 
 namespace fsv {
 	using filter = std::function<bool(const char&)>;
-	class filtered_string_view {
+
+	// the "true" predicate: keeps every character
+	struct true_predicate {
+		constexpr auto operator()(const char&) const noexcept -> bool {
+			return true;
+		}
+	};
+
+	// anything callable as bool(const char&) can be used to filter a view
+	template<typename Pred>
+	concept char_predicate = std::copy_constructible<Pred> and std::predicate<const Pred&, const char&>;
+
+	// a set of characters stored as a 256-bit table. views filtering with a char_class, either directly or
+	// through a filter holding one, count and copy their characters with vectorised kernels instead of
+	// calling the predicate once per character.
+	class char_class {
+	 public:
+		constexpr char_class() noexcept = default;
+
+		constexpr explicit char_class(std::string_view chars) noexcept {
+			for (auto const c : chars) {
+				insert(c);
+			}
+		}
+
+		template<std::input_iterator It, std::sentinel_for<It> Sent>
+		constexpr char_class(It first, Sent last) {
+			for (; first != last; ++first) {
+				insert(static_cast<char>(*first));
+			}
+		}
+
+		// the characters for which pred returns true
+		template<char_predicate Pred>
+		static constexpr auto from(const Pred& pred) -> char_class {
+			auto cls = char_class{};
+			for (auto c = 0; c < 256; ++c) {
+				if (pred(static_cast<char>(c))) {
+					cls.insert(static_cast<char>(c));
+				}
+			}
+			return cls;
+		}
+
+		static constexpr auto digits() noexcept -> char_class {
+			return char_class{"0123456789"};
+		}
+
+		static constexpr auto hex_digits() noexcept -> char_class {
+			return char_class{"0123456789abcdefABCDEF"};
+		}
+
+		static constexpr auto whitespace() noexcept -> char_class {
+			return char_class{" \t\n\v\f\r"};
+		}
+
+		static constexpr auto lower() noexcept -> char_class {
+			return char_class{"abcdefghijklmnopqrstuvwxyz"};
+		}
+
+		static constexpr auto upper() noexcept -> char_class {
+			return char_class{"ABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+		}
+
+		static constexpr auto alpha() noexcept -> char_class {
+			return lower() | upper();
+		}
+
+		static constexpr auto alnum() noexcept -> char_class {
+			return alpha() | digits();
+		}
+
+		constexpr auto insert(char c) noexcept -> char_class& {
+			auto const uc = static_cast<unsigned char>(c);
+			bits_[uc / 64] |= std::uint64_t{1} << (uc % 64);
+			return *this;
+		}
+
+		constexpr auto contains(char c) const noexcept -> bool {
+			auto const uc = static_cast<unsigned char>(c);
+			return (bits_[uc / 64] >> (uc % 64) & 1) != 0;
+		}
+
+		constexpr auto operator()(const char& c) const noexcept -> bool {
+			return contains(c);
+		}
+
+		// number of characters in the class
+		constexpr auto count() const noexcept -> std::size_t {
+			auto n = std::size_t{0};
+			for (auto const word : bits_) {
+				n += static_cast<std::size_t>(std::popcount(word));
+			}
+			return n;
+		}
+
+		friend constexpr auto operator|(char_class lhs, const char_class& rhs) noexcept -> char_class {
+			for (auto i = std::size_t{0}; i < lhs.bits_.size(); ++i) {
+				lhs.bits_[i] |= rhs.bits_[i];
+			}
+			return lhs;
+		}
+
+		friend constexpr auto operator&(char_class lhs, const char_class& rhs) noexcept -> char_class {
+			for (auto i = std::size_t{0}; i < lhs.bits_.size(); ++i) {
+				lhs.bits_[i] &= rhs.bits_[i];
+			}
+			return lhs;
+		}
+
+		friend constexpr auto operator~(char_class cls) noexcept -> char_class {
+			for (auto& word : cls.bits_) {
+				word = ~word;
+			}
+			return cls;
+		}
+
+		friend constexpr auto operator==(const char_class& lhs, const char_class& rhs) noexcept -> bool = default;
+
+	 private:
+		std::array<std::uint64_t, 4> bits_ = {};
+	};
+
+	// a statically typed conjunction of predicates: keeps a character when every predicate does, calling them
+	// in order and stopping at the first which does not
+	template<char_predicate... Preds>
+	class conjunction {
+	 public:
+		constexpr explicit conjunction(Preds... preds)
+		: preds_{std::move(preds)...} {}
+
+		constexpr auto operator()(const char& c) const -> bool {
+			return std::apply([&c](const Preds&... preds) { return (static_cast<bool>(preds(c)) and ...); }, preds_);
+		}
+
+	 private:
+		std::tuple<Preds...> preds_;
+	};
+
+	// how the parallel overloads split their work: the underlying range is cut into one chunk per thread,
+	// each of at least grain characters, on up to threads threads (0 for one per hardware thread), the
+	// calling thread included. their predicate is called from all of those threads at once.
+	struct parallel {
+		std::size_t threads = 0;
+		std::size_t grain = std::size_t{1} << 20;
+	};
+
+	namespace detail {
+		constexpr auto count_kept_scalar(const char* str, std::size_t length, const char_class& cls) noexcept
+		    -> std::size_t {
+			auto kept = std::size_t{0};
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				kept += cls.contains(str[i]) ? 1 : 0;
+			}
+			return kept;
+		}
+
+		// writes the kept characters of [str, str + length) to out, which must have room for length characters
+		constexpr auto
+		compress_kept_scalar(const char* str, std::size_t length, const char_class& cls, char* out) noexcept
+		    -> std::size_t {
+			auto kept = std::size_t{0};
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				out[kept] = str[i];
+				kept += cls.contains(str[i]) ? 1 : 0;
+			}
+			return kept;
+		}
+
+#ifdef FSV_HAS_AVX2_KERNELS
+		// splits the table into two 16-entry tables indexed by the low nibble of a character, whose bits are
+		// indexed by the high nibble (0-7 in low_rows, 8-15 in high_rows), so that pshufb can look them up
+		inline auto nibble_tables(const char_class& cls, std::uint8_t* low_rows, std::uint8_t* high_rows) noexcept
+		    -> void {
+			for (auto c = 0; c < 256; ++c) {
+				if (cls.contains(static_cast<char>(c))) {
+					auto& row = c < 128 ? low_rows[c & 0x0f] : high_rows[c & 0x0f];
+					row = static_cast<std::uint8_t>(row | (1u << ((c >> 4) & 7)));
+				}
+			}
+		}
+
+		// counts the kept characters 32 at a time, also compressing them into out when Compress is set
+		template<bool Compress>
+		__attribute__((target("avx2"))) inline auto
+		scan_kept_avx2(const char* str, std::size_t length, const char_class& cls, char* out) noexcept -> std::size_t {
+			alignas(16) std::uint8_t low[16] = {};
+			alignas(16) std::uint8_t high[16] = {};
+			nibble_tables(cls, low, high);
+			auto const low_rows = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(low)));
+			auto const high_rows = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(high)));
+			auto const bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+			                                   1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+			auto const nibble = _mm256_set1_epi8(0x0f);
+
+			auto kept = std::size_t{0};
+			auto i = std::size_t{0};
+			for (; i + 32 <= length; i += 32) {
+				auto const x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+				auto const lo = _mm256_and_si256(x, nibble);
+				auto const hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+				// the top bit of x picks the row table for characters >= 128
+				auto const rows =
+				    _mm256_blendv_epi8(_mm256_shuffle_epi8(low_rows, lo), _mm256_shuffle_epi8(high_rows, lo), x);
+				auto const bit = _mm256_shuffle_epi8(bits, hi);
+				auto const hit = _mm256_cmpeq_epi8(_mm256_and_si256(rows, bit), bit);
+				auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(hit));
+				if constexpr (Compress) {
+					if (mask == 0xffffffffu) {
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + kept), x);
+						kept += 32;
+						continue;
+					}
+					for (; mask != 0; mask &= mask - 1) {
+						out[kept++] = str[i + static_cast<std::size_t>(std::countr_zero(mask))];
+					}
+				}
+				else {
+					kept += static_cast<std::size_t>(std::popcount(mask));
+				}
+			}
+			if constexpr (Compress) {
+				return kept + compress_kept_scalar(str + i, length - i, cls, out + kept);
+			}
+			else {
+				return kept + count_kept_scalar(str + i, length - i, cls);
+			}
+		}
+
+		inline auto has_avx2() noexcept -> bool {
+			static auto const supported = [] {
+				__builtin_cpu_init();
+				return __builtin_cpu_supports("avx2") != 0;
+			}();
+			return supported;
+		}
+#endif
+
+		// below this many characters building the SIMD tables costs more than it saves
+		inline constexpr auto simd_threshold = std::size_t{64};
+
+		// the kernels fall back to the scalar loops in constant expressions
+		constexpr auto count_kept(const char* str, std::size_t length, const char_class& cls) noexcept -> std::size_t {
+#ifdef FSV_HAS_AVX2_KERNELS
+			if (not std::is_constant_evaluated() and length >= simd_threshold and has_avx2()) {
+				return scan_kept_avx2<false>(str, length, cls, nullptr);
+			}
+#endif
+			return count_kept_scalar(str, length, cls);
+		}
+
+		constexpr auto compress_kept(const char* str, std::size_t length, const char_class& cls, char* out) noexcept
+		    -> std::size_t {
+#ifdef FSV_HAS_AVX2_KERNELS
+			if (not std::is_constant_evaluated() and length >= simd_threshold and has_avx2()) {
+				return scan_kept_avx2<true>(str, length, cls, out);
+			}
+#endif
+			return compress_kept_scalar(str, length, cls, out);
+		}
+
+		// whether pred is known to keep every character: true_predicate, or a filter holding one
+		template<char_predicate Pred>
+		constexpr auto keeps_everything(const Pred& pred) noexcept -> bool {
+			if constexpr (std::same_as<Pred, true_predicate>) {
+				return true;
+			}
+			else if constexpr (std::same_as<Pred, filter>) {
+				return pred.template target<true_predicate>() != nullptr;
+			}
+			else {
+				return false;
+			}
+		}
+
+		// the char_class behind pred, if there is one: pred itself, or the target of a filter holding one
+		template<char_predicate Pred>
+		constexpr auto char_class_of(const Pred& pred) noexcept -> const char_class* {
+			if constexpr (std::same_as<Pred, char_class>) {
+				return &pred;
+			}
+			else if constexpr (std::same_as<Pred, filter>) {
+				return pred.template target<char_class>();
+			}
+			else {
+				return nullptr;
+			}
+		}
+
+		// calls fn(run, count) with every maximal run of consecutive kept characters of [str, str + length) in
+		// place, calling pred once per character
+		template<char_predicate Pred, typename Fn>
+		auto for_each_kept_run(const char* str, std::size_t length, const Pred& pred, Fn fn) -> void {
+			if (keeps_everything(pred)) {
+				if (length != 0) {
+					fn(str, length);
+				}
+				return;
+			}
+			auto const scan = [&](const auto& scan_pred) {
+				auto const end = str + length;
+				auto p = std::find_if(str, end, std::cref(scan_pred));
+				while (p != end) {
+					auto const last = std::find_if_not(std::next(p), end, std::cref(scan_pred));
+					fn(p, static_cast<std::size_t>(last - p));
+					p = std::find_if(last, end, std::cref(scan_pred));
+				}
+			};
+			if (auto const* cls = char_class_of(pred)) {
+				scan(*cls);
+			}
+			else {
+				scan(pred);
+			}
+		}
+
+		// calls fn(kept, count) with the kept characters of [str, str + length), compressed block by block into
+		// a stack buffer
+		template<typename Fn>
+		constexpr auto for_each_kept_block(const char* str, std::size_t length, const char_class& cls, Fn fn) -> void {
+			constexpr auto block = std::size_t{4096};
+			char buffer[block];
+			for (auto i = std::size_t{0}; i < length; i += block) {
+				auto const kept = compress_kept(str + i, std::min(block, length - i), cls, buffer);
+				if (kept != 0) {
+					fn(static_cast<const char*>(buffer), kept);
+				}
+			}
+		}
+	} // namespace detail
+
+	namespace detail {
+		// lambdas are copy constructible but not copy assignable, so those are kept in an optional
+		// and rebuilt in place on assignment
+		template<char_predicate Pred>
+		class predicate_box {
+			static constexpr auto assignable = std::is_copy_assignable_v<Pred> and std::is_move_assignable_v<Pred>;
+
+		 public:
+			constexpr explicit predicate_box(Pred pred) noexcept(std::is_nothrow_move_constructible_v<Pred>)
+			: pred_(std::move(pred)) {}
+
+			predicate_box(const predicate_box&) = default;
+			predicate_box(predicate_box&&) noexcept(std::is_nothrow_move_constructible_v<Pred>) = default;
+
+			constexpr auto operator=(const predicate_box& other) -> predicate_box& {
+				if constexpr (assignable) {
+					pred_ = other.pred_;
+				}
+				else if (this != &other) {
+					pred_.emplace(*other.pred_);
+				}
+				return *this;
+			}
+
+			constexpr auto operator=(predicate_box&& other) noexcept(std::is_nothrow_move_constructible_v<Pred>)
+			    -> predicate_box& {
+				if constexpr (assignable) {
+					pred_ = std::move(other.pred_);
+				}
+				else if (this != &other) {
+					pred_.emplace(std::move(*other.pred_));
+				}
+				return *this;
+			}
+
+			~predicate_box() = default;
+
+			constexpr auto get() const noexcept -> const Pred& {
+				if constexpr (assignable) {
+					return pred_;
+				}
+				else {
+					return *pred_;
+				}
+			}
+
+		 private:
+			std::conditional_t<assignable, Pred, std::optional<Pred>> pred_;
+		};
+
+		// a predicate shared through an intrusive reference count, so that copying it is a pointer copy and an
+		// increment however much state the predicate captures. moving shares too, which leaves moved-from views
+		// with a callable predicate.
+		template<char_predicate Pred>
+		class shared_predicate {
+			struct node {
+				std::atomic<std::size_t> refs;
+				Pred pred;
+			};
+
+		 public:
+			explicit shared_predicate(Pred pred)
+			: node_{new node{1, std::move(pred)}} {}
+
+			shared_predicate(const shared_predicate& other) noexcept
+			: node_{other.node_} {
+				node_->refs.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			auto operator=(const shared_predicate& other) noexcept -> shared_predicate& {
+				auto copy = other;
+				std::swap(node_, copy.node_);
+				return *this;
+			}
+
+			~shared_predicate() {
+				if (node_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					delete node_;
+				}
+			}
+
+			auto get() const noexcept -> const Pred& {
+				return node_->pred;
+			}
+
+			auto shares(const shared_predicate& other) const noexcept -> bool {
+				return node_ == other.node_;
+			}
+
+		 private:
+			node* node_;
+		};
+
+		// small trivially copyable predicates (captureless lambdas, char_class, function pointers) are cheaper
+		// to copy than to share, so they are stored inline
+		template<char_predicate Pred>
+		using predicate_handle = std::conditional_t<std::is_trivially_copyable_v<Pred> and sizeof(Pred) <= 4 * sizeof(void*),
+		                                            predicate_box<Pred>,
+		                                            shared_predicate<Pred>>;
+
+		// whether two handles are known to hold the same predicate: the same shared one, or equal inline ones
+		template<char_predicate Pred>
+		constexpr auto same_predicate(const predicate_box<Pred>& lhs, const predicate_box<Pred>& rhs) -> bool {
+			if constexpr (std::equality_comparable<Pred>) {
+				return lhs.get() == rhs.get();
+			}
+			else {
+				return false;
+			}
+		}
+
+		template<char_predicate Pred>
+		auto same_predicate(const shared_predicate<Pred>& lhs, const shared_predicate<Pred>& rhs) noexcept -> bool {
+			return lhs.shares(rhs);
+		}
+
+		// succinct index of the kept positions of a view: one bit per underlying character, plus the number
+		// of kept characters before every block of 8 words. select() is a binary search over the blocks
+		// followed by at most 8 popcounts.
+		class position_index {
+			static constexpr auto word_bits = std::size_t{64};
+			static constexpr auto block_words = std::size_t{8};
+
+		 public:
+			template<char_predicate Pred>
+			position_index(const char* str, std::size_t length, const Pred& pred)
+			: bits_((length + word_bits - 1) / word_bits)
+			, block_rank_{} {
+				block_rank_.reserve(bits_.size() / block_words + 1);
+				auto kept = std::size_t{0};
+				for (auto w = std::size_t{0}; w < bits_.size(); ++w) {
+					if (w % block_words == 0) {
+						block_rank_.push_back(kept);
+					}
+					auto const first = w * word_bits;
+					auto const last = std::min(first + word_bits, length);
+					auto word = std::uint64_t{0};
+					for (auto i = first; i < last; ++i) {
+						word |= std::uint64_t{static_cast<bool>(pred(str[i]))} << (i - first);
+					}
+					bits_[w] = word;
+					kept += static_cast<std::size_t>(std::popcount(word));
+				}
+				size_ = kept;
+			}
+
+			// number of kept characters
+			auto size() const noexcept -> std::size_t {
+				return size_;
+			}
+
+			// offset of the n-th kept character, n must be less than size()
+			auto select(std::size_t n) const noexcept -> std::size_t {
+				auto const block = static_cast<std::size_t>(
+				    std::upper_bound(block_rank_.begin(), block_rank_.end(), n) - block_rank_.begin() - 1);
+				auto remaining = n - block_rank_[block];
+				auto w = block * block_words;
+				for (auto count = static_cast<std::size_t>(std::popcount(bits_[w])); remaining >= count;
+				     count = static_cast<std::size_t>(std::popcount(bits_[w]))) {
+					remaining -= count;
+					++w;
+				}
+				auto word = bits_[w];
+				for (; remaining > 0; --remaining) {
+					word &= word - 1;
+				}
+				return w * word_bits + static_cast<std::size_t>(std::countr_zero(word));
+			}
+
+		 private:
+			std::vector<std::uint64_t> bits_;
+			std::vector<std::size_t> block_rank_;
+			std::size_t size_ = 0;
+		};
+
+		// the maximal runs of consecutive kept characters of a range, as [first, last) offsets, with the number
+		// of kept characters before each run. a range whose predicate keeps long runs is then copied, written
+		// and compared a run at a time, and the n-th kept character is found by a binary search over the runs.
+		class run_list {
+		 public:
+			struct run {
+				std::size_t first;
+				std::size_t last;
+				std::size_t kept_before;
+			};
+
+			template<char_predicate Pred>
+			run_list(const char* str, std::size_t length, const Pred& pred)
+			: length_{length} {
+				for_each_kept_run(str, length, pred, [&](const char* run, std::size_t count) {
+					auto const first = static_cast<std::size_t>(run - str);
+					runs_.push_back({first, first + count, size_});
+					size_ += count;
+				});
+			}
+
+			auto runs() const noexcept -> std::span<const run> {
+				return runs_;
+			}
+
+			// number of kept characters
+			auto size() const noexcept -> std::size_t {
+				return size_;
+			}
+
+			// offset of the n-th kept character, or the length of the range if there is none
+			auto offset(std::size_t n) const noexcept -> std::size_t {
+				if (n >= size_) {
+					return length_;
+				}
+				auto const next = std::upper_bound(runs_.begin(), runs_.end(), n, [](std::size_t pos, const run& r) {
+					return pos < r.kept_before;
+				});
+				auto const& r = *std::prev(next);
+				return r.first + (n - r.kept_before);
+			}
+
+			// calls fn(run_first, run_last) with every run overlapping the offsets [first, last), cut to them
+			template<typename Fn>
+			auto for_each_run(std::size_t first, std::size_t last, Fn fn) const -> void {
+				auto it = std::partition_point(runs_.begin(), runs_.end(), [first](const run& r) {
+					return r.last <= first;
+				});
+				for (; it != runs_.end() and it->first < last; ++it) {
+					fn(std::max(it->first, first), std::min(it->last, last));
+				}
+			}
+
+		 private:
+			std::vector<run> runs_;
+			std::size_t size_ = 0;
+			std::size_t length_;
+		};
+
+		// a structure over the kept characters of a view (a position_index or a run_list) which is built on
+		// first use and shared between copies of the view
+		template<typename T>
+		class lazy_slot {
+		 public:
+			template<char_predicate Pred>
+			auto get(const char* str, std::size_t length, const Pred& pred) -> const T& {
+				std::call_once(once_, [&] { value_.emplace(str, length, pred); });
+				return *value_;
+			}
+
+		 private:
+			std::once_flag once_;
+			std::optional<T> value_;
+		};
+
+		// a lazy_slot shared between the copies of a view through an intrusive reference count like
+		// shared_predicate. unlike std::shared_ptr, an empty one can be made, copied and destroyed in constant
+		// expressions, which keeps views without an index usable there.
+		template<typename T>
+		class shared_slot {
+			struct node {
+				std::atomic<std::size_t> refs;
+				lazy_slot<T> slot;
+			};
+
+		 public:
+			constexpr shared_slot() noexcept = default;
+
+			static auto make() -> shared_slot {
+				auto slot = shared_slot{};
+				slot.node_ = new node{1, {}};
+				return slot;
+			}
+
+			constexpr shared_slot(const shared_slot& other) noexcept
+			: node_{other.node_} {
+				if (node_ != nullptr) {
+					node_->refs.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			constexpr shared_slot(shared_slot&& other) noexcept
+			: node_{std::exchange(other.node_, nullptr)} {}
+
+			constexpr auto operator=(shared_slot other) noexcept -> shared_slot& {
+				std::swap(node_, other.node_);
+				return *this;
+			}
+
+			constexpr ~shared_slot() {
+				if (node_ != nullptr and node_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					delete node_;
+				}
+			}
+
+			constexpr auto empty() const noexcept -> bool {
+				return node_ == nullptr;
+			}
+
+			// the structure of a non-empty slot, built by the first caller
+			template<char_predicate Pred>
+			auto get(const char* str, std::size_t length, const Pred& pred) const -> const T& {
+				return node_->slot.get(str, length, pred);
+			}
+
+		 private:
+			node* node_ = nullptr;
+		};
+
+		// the predicate made by compose() from a list of filters
+		struct filter_chain {
+			std::vector<filter> filters;
+
+			auto operator()(const char& c) const -> bool {
+				return std::all_of(filters.begin(), filters.end(), [&c](const filter& f) { return f(c); });
+			}
+		};
+
+		// flattens the chains made by earlier compose() calls into filts, drops "true" predicates and merges
+		// each run of adjacent char_classes into one. char_classes have no side effects, so merging adjacent
+		// ones keeps the order in which the remaining filters are called, and where they stop.
+		inline auto fuse_filters(const std::vector<filter>& filts) -> filter {
+			auto fused = std::vector<filter>{};
+			auto const append = [&fused](const filter& f) {
+				if (f.target<true_predicate>() != nullptr) {
+					return;
+				}
+				auto const* cls = f.target<char_class>();
+				auto* last = fused.empty() ? nullptr : fused.back().target<char_class>();
+				if (cls != nullptr and last != nullptr) {
+					*last = *last & *cls;
+				}
+				else {
+					fused.push_back(f);
+				}
+			};
+			for (auto const& f : filts) {
+				if (auto const* chain = f.target<filter_chain>()) {
+					std::for_each(chain->filters.begin(), chain->filters.end(), append);
+				}
+				else {
+					append(f);
+				}
+			}
+
+			if (fused.empty()) {
+				return true_predicate{};
+			}
+			if (fused.size() == 1) {
+				return fused.front();
+			}
+			return filter_chain{std::move(fused)};
+		}
+
+		// the bad character shifts of Boyer-Moore-Horspool for a needle
+		class horspool_table {
+		 public:
+			template<std::ranges::random_access_range Needle>
+			constexpr explicit horspool_table(const Needle& needle) noexcept {
+				auto const m = static_cast<std::size_t>(std::ranges::size(needle));
+				shift_.fill(m);
+				for (auto i = std::size_t{0}; i + 1 < m; ++i) {
+					shift_[static_cast<unsigned char>(needle[i])] = m - 1 - i;
+				}
+			}
+
+			constexpr auto shift(char c) const noexcept -> std::size_t {
+				return shift_[static_cast<unsigned char>(c)];
+			}
+
+		 private:
+			std::array<std::size_t, 256> shift_;
+		};
+
+		template<typename It>
+		struct kept_search_result {
+			It first; // the first matched character
+			It last; // the last matched character
+			std::size_t skipped; // kept characters before first, or all kept characters when not found
+			bool found;
+		};
+
+		// Boyer-Moore-Horspool over the characters of [first, last) kept by pred. the window slides over kept
+		// characters only and is compared from its last character backwards, so filtered-out bytes are never
+		// compared; when nothing is filtered out (true_predicate) the window jumps without looking at the
+		// skipped bytes at all. needle must not be empty.
+		template<std::random_access_iterator It, char_predicate Pred, std::ranges::random_access_range Needle>
+		constexpr auto
+		horspool_search(It first, It last, const Pred& pred, const Needle& needle, const horspool_table& table)
+		    -> kept_search_result<It> {
+			constexpr auto keeps_everything = std::same_as<Pred, true_predicate>;
+			auto const m = static_cast<std::size_t>(std::ranges::size(needle));
+
+			auto window_last = first;
+			if constexpr (not keeps_everything) {
+				window_last = std::find_if(first, last, std::cref(pred));
+			}
+			if (window_last == last) {
+				return {last, last, 0, false};
+			}
+			// index of window_last among the kept characters
+			auto pos = std::size_t{0};
+			// moves window_last forward by n kept characters, returning false if it runs into last
+			auto const advance = [&](std::size_t n) -> bool {
+				if constexpr (keeps_everything) {
+					if (static_cast<std::size_t>(last - window_last) <= n) {
+						pos = static_cast<std::size_t>(last - first) - 1;
+						return false;
+					}
+					window_last += static_cast<std::ptrdiff_t>(n);
+					pos += n;
+					return true;
+				}
+				else {
+					for (; n > 0; --n) {
+						auto const next = std::find_if(std::next(window_last), last, std::cref(pred));
+						if (next == last) {
+							return false;
+						}
+						window_last = next;
+						++pos;
+					}
+					return true;
+				}
+			};
+
+			if (not advance(m - 1)) {
+				return {last, last, pos + 1, false};
+			}
+			while (true) {
+				auto it = window_last;
+				for (auto j = m - 1; *it == needle[j]; --j) {
+					if (j == 0) {
+						return {it, window_last, pos + 1 - m, true};
+					}
+					// the window holds m kept characters, so there is always one before it
+					do {
+						--it;
+					} while (not pred(*it));
+				}
+				if (not advance(table.shift(*window_last))) {
+					return {last, last, pos + 1, false};
+				}
+			}
+		}
+
+		// all char_classes fuse into one table, anything else becomes a conjunction
+		template<char_predicate... Preds>
+		using composed_predicate_t =
+		    std::conditional_t<(std::same_as<Preds, char_class> and ...), char_class, conjunction<Preds...>>;
+
+		// calls fn with the cheapest predicate equivalent to pred for a scan: true_predicate, the char_class
+		// behind pred, or pred itself
+		template<char_predicate Pred, typename Fn>
+		constexpr auto with_scan_predicate(const Pred& pred, Fn fn) -> decltype(auto) {
+			if (keeps_everything(pred)) {
+				return fn(true_predicate{});
+			}
+			if (auto const* cls = char_class_of(pred)) {
+				return fn(*cls);
+			}
+			return fn(pred);
+		}
+
+		// reads the kept characters of a range a block at a time: the whole range at once when cls is null
+		// (everything is kept), a run at a time from a run_list, or compressed into a buffer by the char_class
+		// kernels
+		class kept_block_reader {
+		 public:
+			constexpr kept_block_reader(const char* str, std::size_t length, const char_class* cls) noexcept
+			: str_{str}
+			, length_{length}
+			, cls_{cls} {}
+
+			kept_block_reader(const char* str, std::span<const run_list::run> runs) noexcept
+			: str_{str}
+			, length_{0}
+			, cls_{nullptr}
+			, runs_{runs} {}
+
+			// the next non-empty block, or an empty one at the end of the range
+			constexpr auto next() noexcept -> std::string_view {
+				if (not runs_.empty()) {
+					auto const& run = runs_.front();
+					runs_ = runs_.subspan(1);
+					return {str_ + run.first, run.last - run.first};
+				}
+				if (cls_ == nullptr) {
+					return {std::exchange(str_, str_ + length_), std::exchange(length_, 0)};
+				}
+				while (length_ != 0) {
+					auto const count = std::min(buffer_.size(), length_);
+					auto const kept = compress_kept(str_, count, *cls_, buffer_.data());
+					str_ += count;
+					length_ -= count;
+					if (kept != 0) {
+						return {buffer_.data(), kept};
+					}
+				}
+				return {};
+			}
+
+		 private:
+			const char* str_;
+			std::size_t length_;
+			const char_class* cls_;
+			std::span<const run_list::run> runs_;
+			std::array<char, 4096> buffer_;
+		};
+
+		// lexicographic comparison of the characters read by two kept_block_readers, by unsigned byte, with
+		// char_traits::compare (memcmp, at runtime) over the overlap of the current blocks
+		constexpr auto compare_blocks(kept_block_reader& lreader, kept_block_reader& rreader) -> std::strong_ordering {
+			auto lblock = std::string_view{};
+			auto rblock = std::string_view{};
+			while (true) {
+				if (lblock.empty()) {
+					lblock = lreader.next();
+				}
+				if (rblock.empty()) {
+					rblock = rreader.next();
+				}
+				if (lblock.empty() or rblock.empty()) {
+					return not lblock.empty() <=> not rblock.empty();
+				}
+				auto const count = std::min(lblock.size(), rblock.size());
+				if (auto const cmp = std::char_traits<char>::compare(lblock.data(), rblock.data(), count); cmp != 0) {
+					return cmp <=> 0;
+				}
+				lblock.remove_prefix(count);
+				rblock.remove_prefix(count);
+			}
+		}
+
+		// lexicographic comparison of the kept characters of two ranges, by unsigned byte like std::string.
+		// when both predicates keep everything or are char_classes the kept characters are compared a block at
+		// a time by compare_blocks; otherwise a cursor on each side walks to its next kept character, so that
+		// each predicate is called at most once per character and nothing past the first difference is read.
+		template<char_predicate LPred, char_predicate RPred>
+		constexpr auto compare_kept(const char* lstr,
+		                            std::size_t llength,
+		                            const LPred& lpred,
+		                            const char* rstr,
+		                            std::size_t rlength,
+		                            const RPred& rpred) -> std::strong_ordering {
+			auto const* lcls = keeps_everything(lpred) ? nullptr : char_class_of(lpred);
+			auto const* rcls = keeps_everything(rpred) ? nullptr : char_class_of(rpred);
+			if ((lcls != nullptr or keeps_everything(lpred)) and (rcls != nullptr or keeps_everything(rpred))) {
+				auto lreader = kept_block_reader{lstr, llength, lcls};
+				auto rreader = kept_block_reader{rstr, rlength, rcls};
+				return compare_blocks(lreader, rreader);
+			}
+
+			return with_scan_predicate(lpred, [&](const auto& lscan) {
+				return with_scan_predicate(rpred, [&](const auto& rscan) {
+					auto l = lstr;
+					auto r = rstr;
+					auto const lend = lstr + llength;
+					auto const rend = rstr + rlength;
+					while (true) {
+						l = std::find_if(l, lend, std::cref(lscan));
+						r = std::find_if(r, rend, std::cref(rscan));
+						if (l == lend or r == rend) {
+							return (l != lend) <=> (r != rend);
+						}
+						if (*l != *r) {
+							return static_cast<unsigned char>(*l) <=> static_cast<unsigned char>(*r);
+						}
+						++l;
+						++r;
+					}
+				});
+			});
+		}
+
+		// the number of kept characters in [str, str + length)
+		template<char_predicate Pred>
+		constexpr auto count_kept_by(const char* str, std::size_t length, const Pred& pred) -> std::size_t {
+			if (keeps_everything(pred)) {
+				return length;
+			}
+			if (auto const* cls = char_class_of(pred)) {
+				return count_kept(str, length, *cls);
+			}
+			return static_cast<std::size_t>(std::count_if(str, str + length, std::cref(pred)));
+		}
+
+		// writes the kept characters of [str, str + length) to out, and nothing past them
+		template<char_predicate Pred>
+		constexpr auto copy_kept_by(const char* str, std::size_t length, const Pred& pred, char* out) -> void {
+			if (keeps_everything(pred)) {
+				std::copy_n(str, length, out);
+			}
+			else if (auto const* cls = char_class_of(pred)) {
+				// compress_kept may write one character past the kept ones, which another thread may own
+				for_each_kept_block(str, length, *cls, [&out](const char* kept, std::size_t count) {
+					out = std::copy_n(kept, count, out);
+				});
+			}
+			else {
+				std::copy_if(str, str + length, out, std::cref(pred));
+			}
+		}
+
+		// calls fn(kept, count) with the kept characters of [str, str + length) in order, in blocks: the range
+		// itself when everything is kept, compressed blocks for a char_class, or batches gathered into a stack
+		// buffer otherwise, so that fn never sees a single character at a time
+		template<char_predicate Pred, typename Fn>
+		auto for_each_kept_block_by(const char* str, std::size_t length, const Pred& pred, Fn fn) -> void {
+			if (keeps_everything(pred)) {
+				if (length != 0) {
+					fn(str, length);
+				}
+			}
+			else if (auto const* cls = char_class_of(pred)) {
+				for_each_kept_block(str, length, *cls, fn);
+			}
+			else {
+				constexpr auto block = std::size_t{256};
+				char buffer[block];
+				auto kept = std::size_t{0};
+				for (auto const* p = str; p != str + length; ++p) {
+					if (pred(*p)) {
+						buffer[kept++] = *p;
+						if (kept == block) {
+							fn(static_cast<const char*>(buffer), std::exchange(kept, 0));
+						}
+					}
+				}
+				if (kept != 0) {
+					fn(static_cast<const char*>(buffer), kept);
+				}
+			}
+		}
+
+		// 64-bit xxHash (XXH64) fed incrementally: the digest depends only on the bytes fed, not on how they
+		// were split across update() calls. words are read in the byte order of the machine.
+		class xxh64 {
+			static constexpr auto prime1 = std::uint64_t{11400714785074694791u};
+			static constexpr auto prime2 = std::uint64_t{14029467366897019727u};
+			static constexpr auto prime3 = std::uint64_t{1609587929392839161u};
+			static constexpr auto prime4 = std::uint64_t{9650029242287828579u};
+			static constexpr auto prime5 = std::uint64_t{2870177450012600261u};
+			static constexpr auto stripe = std::size_t{32};
+
+		 public:
+			explicit xxh64(std::uint64_t seed = 0) noexcept
+			: lanes_{seed + prime1 + prime2, seed + prime2, seed, seed - prime1}
+			, seed_{seed} {}
+
+			auto update(const char* data, std::size_t length) noexcept -> void {
+				total_ += length;
+				if (buffered_ != 0) {
+					auto const count = std::min(stripe - buffered_, length);
+					std::memcpy(buffer_.data() + buffered_, data, count);
+					buffered_ += count;
+					data += count;
+					length -= count;
+					if (buffered_ < stripe) {
+						return;
+					}
+					consume(buffer_.data());
+					buffered_ = 0;
+				}
+				for (; length >= stripe; data += stripe, length -= stripe) {
+					consume(data);
+				}
+				std::memcpy(buffer_.data(), data, length);
+				buffered_ = length;
+			}
+
+			auto digest() const noexcept -> std::uint64_t {
+				auto h = total_ >= stripe ? std::rotl(lanes_[0], 1) + std::rotl(lanes_[1], 7) + std::rotl(lanes_[2], 12)
+				                                + std::rotl(lanes_[3], 18)
+				                          : seed_ + prime5;
+				if (total_ >= stripe) {
+					for (auto const lane : lanes_) {
+						h = (h ^ round(0, lane)) * prime1 + prime4;
+					}
+				}
+				h += total_;
+
+				auto const* p = buffer_.data();
+				auto const* const end = p + buffered_;
+				for (; p + 8 <= end; p += 8) {
+					h = std::rotl(h ^ round(0, read<std::uint64_t>(p)), 27) * prime1 + prime4;
+				}
+				if (p + 4 <= end) {
+					h = std::rotl(h ^ std::uint64_t{read<std::uint32_t>(p)} * prime1, 23) * prime2 + prime3;
+					p += 4;
+				}
+				for (; p != end; ++p) {
+					h = std::rotl(h ^ std::uint64_t{static_cast<unsigned char>(*p)} * prime5, 11) * prime1;
+				}
+
+				h ^= h >> 33;
+				h *= prime2;
+				h ^= h >> 29;
+				h *= prime3;
+				h ^= h >> 32;
+				return h;
+			}
+
+		 private:
+			std::array<std::uint64_t, 4> lanes_;
+			std::array<char, stripe> buffer_ = {};
+			std::size_t buffered_ = 0;
+			std::uint64_t total_ = 0;
+			std::uint64_t seed_;
+
+			static auto round(std::uint64_t acc, std::uint64_t input) noexcept -> std::uint64_t {
+				return std::rotl(acc + input * prime2, 31) * prime1;
+			}
+
+			template<typename Word>
+			static auto read(const char* p) noexcept -> Word {
+				auto word = Word{};
+				std::memcpy(&word, p, sizeof(word));
+				return word;
+			}
+
+			auto consume(const char* p) noexcept -> void {
+				for (auto i = std::size_t{0}; i < lanes_.size(); ++i) {
+					lanes_[i] = round(lanes_[i], read<std::uint64_t>(p + 8 * i));
+				}
+			}
+		};
+
+		// the number of chunks to cut length characters into
+		inline auto parallel_chunks(const parallel& policy, std::size_t length) noexcept -> std::size_t {
+			auto const hardware = static_cast<std::size_t>(std::thread::hardware_concurrency());
+			auto const threads = std::max(policy.threads != 0 ? policy.threads : hardware, std::size_t{1});
+			return std::clamp(length / std::max(policy.grain, std::size_t{1}), std::size_t{1}, threads);
+		}
+
+		// the offset of the first character of chunk i when length characters are cut into n even chunks
+		inline auto chunk_offset(std::size_t length, std::size_t i, std::size_t n) noexcept -> std::size_t {
+			return length / n * i + std::min(i, length % n);
+		}
+
+		// calls fn(i) for every i in [0, n), each on a thread of its own but fn(0), which runs on the calling
+		// thread. once every call has returned, the first exception any of them threw is rethrown.
+		template<typename Fn>
+		auto parallel_for(std::size_t n, Fn fn) -> void {
+			auto errors = std::vector<std::exception_ptr>(n);
+			auto const run = [&fn, &errors](std::size_t i) {
+				try {
+					fn(i);
+				} catch (...) {
+					errors[i] = std::current_exception();
+				}
+			};
+			{
+				auto workers = std::vector<std::jthread>{};
+				workers.reserve(n - 1);
+				for (auto i = std::size_t{1}; i < n; ++i) {
+					workers.emplace_back(run, i);
+				}
+				run(0);
+			}
+			for (auto const& error : errors) {
+				if (error != nullptr) {
+					std::rethrow_exception(error);
+				}
+			}
+		}
+
+		// a string of size characters, all written by fill(data). where the library has resize_and_overwrite
+		// (C++23) the characters are left unwritten until fill() gets to them, so that threads filling their
+		// own parts of a large string are the first to touch its pages; otherwise the string is zeroed first.
+		template<typename Fill>
+		auto string_for_overwrite(std::size_t size, Fill fill) -> std::string {
+			auto str = std::string{};
+#ifdef __cpp_lib_string_resize_and_overwrite
+			// the operation must not throw, so what fill() throws is caught and rethrown afterwards
+			auto error = std::exception_ptr{};
+			str.resize_and_overwrite(size, [&fill, &error](char* data, std::size_t count) noexcept -> std::size_t {
+				try {
+					fill(data);
+					return count;
+				} catch (...) {
+					error = std::current_exception();
+					return 0;
+				}
+			});
+			if (error != nullptr) {
+				std::rethrow_exception(error);
+			}
+#else
+			str.resize(size);
+			fill(str.data());
+#endif
+			return str;
+		}
+	} // namespace detail
+
+	template<char_predicate Pred = filter>
+	class basic_filtered_string_view;
+
+	template<char_predicate Pred>
+	class split_view;
+
+	template<char_predicate Pred>
+	class basic_indexed_view;
+
+	class multi_matcher;
+
+	struct hash;
+	struct equal_to;
+
+	namespace detail {
+		template<typename T>
+		inline constexpr auto is_filtered_view = false;
+
+		template<char_predicate Pred>
+		inline constexpr auto is_filtered_view<basic_filtered_string_view<Pred>> = true;
+	} // namespace detail
+
+	// the type-erased view, which accepts any predicate at runtime
+	using filtered_string_view = basic_filtered_string_view<filter>;
+
+	// non-member utility functions
+	template<char_predicate Pred>
+	auto compose(const basic_filtered_string_view<Pred>& fsv, const std::vector<filter>& filts) noexcept
+	    -> filtered_string_view;
+
+	template<char_predicate Pred, char_predicate... Preds>
+	requires(sizeof...(Preds) > 0)
+	auto compose(const basic_filtered_string_view<Pred>& fsv, Preds... preds)
+	    -> basic_filtered_string_view<detail::composed_predicate_t<Preds...>>;
+
+	template<char_predicate Pred, char_predicate TokPred>
+	constexpr auto split(const basic_filtered_string_view<Pred>& fsv, const basic_filtered_string_view<TokPred>& tok)
+	    -> std::vector<basic_filtered_string_view<Pred>>;
+
+	template<char_predicate Pred, char_predicate TokPred>
+	constexpr auto split(const basic_filtered_string_view<Pred>& fsv,
+	                     const basic_filtered_string_view<TokPred>& tok,
+	                     std::type_identity_t<std::span<basic_filtered_string_view<Pred>>> out) -> std::size_t;
+
+	template<char_predicate Pred>
+	constexpr auto substr(const basic_filtered_string_view<Pred>& fsv, int pos = 0, int count = 0)
+	    -> basic_filtered_string_view<Pred>;
+
+	template<char_predicate Pred>
+	auto size(const parallel& policy, const basic_filtered_string_view<Pred>& fsv) -> std::size_t;
+
+	template<char_predicate Pred, char_predicate TokPred>
+	auto split(const parallel& policy,
+	           const basic_filtered_string_view<Pred>& fsv,
+	           const basic_filtered_string_view<TokPred>& tok) -> std::vector<basic_filtered_string_view<Pred>>;
+
+	template<char_predicate Pred>
+	auto to_string(const parallel& policy, const basic_filtered_string_view<Pred>& fsv) -> std::string;
+
+	template<char_predicate... Preds>
+	auto materialize_into(std::pmr::memory_resource& arena, const basic_filtered_string_view<Preds>&... views)
+	    -> std::array<std::string_view, sizeof...(Preds)>;
+
+	template<std::ranges::forward_range Views>
+	requires detail::is_filtered_view<std::ranges::range_value_t<Views>>
+	auto materialize_into(std::pmr::memory_resource& arena, const Views& views) -> std::pmr::vector<std::string_view>;
+
+	template<char_predicate Pred, char_predicate TokPred>
+	auto split(std::pmr::memory_resource& arena,
+	           const basic_filtered_string_view<Pred>& fsv,
+	           const basic_filtered_string_view<TokPred>& tok) -> std::pmr::vector<std::string_view>;
+
+	template<char_predicate Pred>
+	auto write_to(std::ostream& os, const basic_filtered_string_view<Pred>& fsv) -> std::ostream&;
+
+	namespace detail {
+		template<char_predicate Pred>
+		auto insert_kept(std::ostream& os, const basic_filtered_string_view<Pred>& fsv) -> std::ostream&;
+	} // namespace detail
+
+	template<std::ranges::input_range Views>
+	requires detail::is_filtered_view<std::ranges::range_value_t<Views>>
+	auto write_to(std::ostream& os, const Views& views, std::string_view separator = {}) -> std::ostream&;
+
+	// a view over a string which only shows the characters kept by Pred; statically typed predicates
+	// (lambdas, function objects) are inlined into the scanning loops, while filtered_string_view erases
+	// the predicate behind fsv::filter
+	template<char_predicate Pred>
+	class basic_filtered_string_view {
+		// the iterator refers to its view for the bounds and the predicate, which keeps it to two pointers and
+		// trivially copyable. like the iterators of std::ranges::filter_view, it must not outlive its view, nor
+		// be used after the view has been moved from or assigned to.
 		class iter {
 		 public:
 			using iterator_category = std::bidirectional_iterator_tag;
@@ -21,132 +1260,1787 @@ namespace fsv {
 			using reference = const char&;
 			using pointer = void;
 			using difference_type = std::ptrdiff_t;
-			iter() noexcept;
 
-			auto operator*() const -> reference;
-			auto operator->() const -> pointer;
+			iter() noexcept = default;
+
+			constexpr auto operator*() const -> reference {
+				return *current_;
+			}
+
+			auto operator->() const -> pointer {}
+
+			constexpr auto operator++() -> iter& {
+				increment_ptr(current_);
+				return *this;
+			}
+
+			constexpr auto operator++(int) -> iter {
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			constexpr auto operator--() -> iter& {
+				decrement_ptr(current_);
+				return *this;
+			}
+
+			constexpr auto operator--(int) -> iter {
+				auto copy = *this;
+				--*this;
+				return copy;
+			}
 
-			auto operator++() -> iter&;
-			auto operator++(int) -> iter;
-			auto operator--() -> iter&;
-			auto operator--(int) -> iter;
+			friend constexpr auto operator==(const iter& lhs, const iter& rhs) noexcept -> bool {
+				return lhs.current_ == rhs.current_;
+			}
 
-			friend auto operator==(const iter&, const iter&) noexcept -> bool;
-			friend auto operator!=(const iter&, const iter&) noexcept -> bool;
+			friend constexpr auto operator!=(const iter& lhs, const iter& rhs) noexcept -> bool {
+				return not(lhs == rhs);
+			}
 
 		 private:
 			using ptr = const char*;
-			iter(ptr start, ptr end, ptr curr, filter predicate);
 
-			auto increment_ptr(ptr&) -> void;
-			auto decrement_ptr(ptr&) -> void;
-			ptr start_;
-			ptr current_;
-			ptr end_;
-			filter predicate_;
+			constexpr iter(const basic_filtered_string_view* view, ptr curr)
+			: view_{view}
+			, current_{curr} {}
 
-			friend class filtered_string_view;
+			// moves to the next kept character, or to the end of the view if there is none
+			constexpr auto increment_ptr(ptr& p) -> void {
+				auto const end = view_->strptr_ + view_->length_;
+				if (p == end) {
+					return;
+				}
+				auto const& predicate = view_->predicate_.get();
+				do {
+					++p;
+				} while (p != end and not predicate(*p));
+			}
+
+			// moves to the previous kept character
+			constexpr auto decrement_ptr(ptr& p) -> void {
+				auto const start = view_->strptr_;
+				auto const& predicate = view_->predicate_.get();
+				while (p != start) {
+					--p;
+					if (predicate(*p)) {
+						return;
+					}
+				}
+			}
+
+			const basic_filtered_string_view* view_ = nullptr;
+			ptr current_ = nullptr;
+
+			friend class basic_filtered_string_view;
+		};
+
+		// the forward-only iterator of scan(). it carries its own end, so single-pass loops compare it against
+		// std::default_sentinel instead of a second iterator and never go through the view. the same lifetime
+		// rules as iter apply.
+		class scan_iter {
+		 public:
+			using iterator_concept = std::forward_iterator_tag;
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = char;
+			using reference = const char&;
+			using difference_type = std::ptrdiff_t;
+
+			scan_iter() noexcept = default;
+
+			auto operator*() const -> reference {
+				return *current_;
+			}
+
+			auto operator++() -> scan_iter& {
+				current_ = std::find_if(current_ + 1, end_, std::cref(*predicate_));
+				return *this;
+			}
+
+			auto operator++(int) -> scan_iter {
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			friend auto operator==(const scan_iter& lhs, const scan_iter& rhs) noexcept -> bool {
+				return lhs.current_ == rhs.current_;
+			}
+
+			friend auto operator==(const scan_iter& it, std::default_sentinel_t) noexcept -> bool {
+				return it.current_ == it.end_;
+			}
+
+		 private:
+			scan_iter(const char* current, const char* end, const Pred* predicate)
+			: current_{current}
+			, end_{end}
+			, predicate_{predicate} {}
+
+			const char* current_ = nullptr;
+			const char* end_ = nullptr;
+			const Pred* predicate_ = nullptr;
+
+			friend class basic_filtered_string_view;
 		};
 
 	 public:
-	 	static filter default_predicate;
-		// inline static filter default_predicate = [](const char&) { return true; };
+		using predicate_type = Pred;
+		inline static Pred default_predicate = Pred{true_predicate{}};
 		using iterator = iter;
 		using const_iterator = iterator;
 		using reverse_iterator = std::reverse_iterator<iterator>;
 		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+		using scan_iterator = scan_iter;
+
+		constexpr auto begin() -> iterator {
+			return std::as_const(*this).begin();
+		}
+
+		constexpr auto begin() const -> const_iterator {
+			return iterator{this, std::find_if(strptr_, strptr_ + length_, std::cref(predicate_.get()))};
+		}
+
+		constexpr auto cbegin() const -> const_iterator {
+			return begin();
+		}
+
+		constexpr auto end() -> iterator {
+			return std::as_const(*this).end();
+		}
+
+		constexpr auto end() const -> const_iterator {
+			return iterator{this, strptr_ + length_};
+		}
+
+		constexpr auto cend() const -> const_iterator {
+			return end();
+		}
 
-		auto begin() -> iterator;
-		auto begin() const -> const_iterator;
-		auto cbegin() const -> const_iterator;
+		constexpr auto rbegin() -> reverse_iterator {
+			return reverse_iterator{end()};
+		}
 
-		auto end() -> iterator;
-		auto end() const -> const_iterator;
-		auto cend() const -> const_iterator;
+		constexpr auto rbegin() const -> const_reverse_iterator {
+			return const_reverse_iterator{end()};
+		}
 
-		auto rbegin() -> reverse_iterator;
-		auto rbegin() const -> const_reverse_iterator;
-		auto crbegin() const -> const_reverse_iterator;
+		constexpr auto crbegin() const -> const_reverse_iterator {
+			return rbegin();
+		}
 
-		auto rend() -> reverse_iterator;
-		auto rend() const -> const_reverse_iterator;
-		auto crend() const -> const_reverse_iterator;
+		constexpr auto rend() -> reverse_iterator {
+			return reverse_iterator{begin()};
+		}
 
-		filtered_string_view() noexcept;
+		constexpr auto rend() const -> const_reverse_iterator {
+			return const_reverse_iterator{begin()};
+		}
 
-		filtered_string_view(const std::string& str) noexcept;
+		constexpr auto crend() const -> const_reverse_iterator {
+			return rend();
+		}
 
-		filtered_string_view(const std::string& str, filter predicate) noexcept;
+		// a single-pass range over the kept characters, ending at std::default_sentinel
+		auto scan() const -> std::ranges::subrange<scan_iterator, std::default_sentinel_t> {
+			auto const end = strptr_ + length_;
+			auto const first = std::find_if(strptr_, end, std::cref(predicate_.get()));
+			return {scan_iterator{first, end, &predicate_.get()}, std::default_sentinel};
+		}
 
-		filtered_string_view(const char* str);
+		// the constructors are constexpr, so views over literals can be constinit, when the predicate is
+		// stored inline (char_class, true_predicate, captureless lambdas); fsv::filter never is. such views
+		// can be used in constant expressions too: iterating, size(), operator[], at(), copy(), comparisons,
+		// substr() and split() all are, but find() and the other searches are not, and neither are views
+		// with an index. sizes are not remembered in constant expressions, since atomics cannot be used there.
 
-		filtered_string_view(const char* str, filter predicate);
+		constexpr basic_filtered_string_view() noexcept
+		requires std::constructible_from<Pred, true_predicate>
+		: basic_filtered_string_view{nullptr, 0, default_handle(), 0} {}
+
+		constexpr basic_filtered_string_view(const std::string& str) noexcept
+		requires std::constructible_from<Pred, true_predicate>
+		: basic_filtered_string_view{str.data(), str.size(), default_handle()} {}
+
+		// noexcept only when the predicate is stored inline: a shared one, such as any fsv::filter, is allocated
+		constexpr basic_filtered_string_view(const std::string& str, Pred predicate) noexcept(
+		    std::same_as<detail::predicate_handle<Pred>, detail::predicate_box<Pred>>
+		    and std::is_nothrow_move_constructible_v<Pred>)
+		: basic_filtered_string_view{str.data(), str.size(), detail::predicate_handle<Pred>{std::move(predicate)}} {}
+
+		constexpr basic_filtered_string_view(const char* str)
+		requires std::constructible_from<Pred, true_predicate>
+		: basic_filtered_string_view{str, std::char_traits<char>::length(str), default_handle()} {}
+
+		constexpr basic_filtered_string_view(const char* str, Pred predicate)
+		: basic_filtered_string_view{str,
+		                             std::char_traits<char>::length(str),
+		                             detail::predicate_handle<Pred>{std::move(predicate)}} {}
+
+		// views the length characters at str, which may include NULs and need not be terminated; unlike the
+		// const char* constructors these do not scan str
+		constexpr basic_filtered_string_view(const char* str, std::size_t length)
+		requires std::constructible_from<Pred, true_predicate>
+		: basic_filtered_string_view{str, length, default_handle()} {}
+
+		constexpr basic_filtered_string_view(const char* str, std::size_t length, Pred predicate)
+		: basic_filtered_string_view{str, length, detail::predicate_handle<Pred>{std::move(predicate)}} {}
+
+		constexpr basic_filtered_string_view(std::string_view str)
+		requires std::constructible_from<Pred, true_predicate>
+		: basic_filtered_string_view{str.data(), str.size(), default_handle()} {}
+
+		constexpr basic_filtered_string_view(std::string_view str, Pred predicate)
+		: basic_filtered_string_view{str.data(), str.size(), detail::predicate_handle<Pred>{std::move(predicate)}} {}
+
+		// converts a view with a different predicate type, e.g. a statically typed view to filtered_string_view
+		template<char_predicate Other>
+		requires(not std::same_as<Other, Pred> and std::constructible_from<Pred, const Other&>)
+		constexpr basic_filtered_string_view(const basic_filtered_string_view<Other>& other)
+		: basic_filtered_string_view{other.strptr_,
+		                             other.length_,
+		                             detail::predicate_handle<Pred>{Pred(other.predicate())},
+		                             other.remembered_size()} {}
 
 		// copy constructor
-		filtered_string_view(const filtered_string_view& other) noexcept;
+		constexpr basic_filtered_string_view(const basic_filtered_string_view& other) noexcept
+		: strptr_{other.strptr_}
+		, length_{other.length_}
+		, filtered_length_{other.remembered_size()}
+		, predicate_{other.predicate_}
+		, index_{other.index_}
+		, runs_{other.runs_} {}
 
 		// move constructor
-		filtered_string_view(filtered_string_view&& other) noexcept;
+		constexpr basic_filtered_string_view(basic_filtered_string_view&& other) noexcept
+		: strptr_{std::exchange(other.strptr_, nullptr)}
+		, length_{std::exchange(other.length_, 0)}
+		, filtered_length_{other.remembered_size()}
+		, predicate_{std::move(other.predicate_)}
+		, index_{std::move(other.index_)}
+		, runs_{std::move(other.runs_)} {
+			other.remember_size(0);
+		}
 
 		// destructor
-		~filtered_string_view() noexcept = default;
+		constexpr ~basic_filtered_string_view() noexcept = default;
 
 		// copy assignment
-		auto operator=(const filtered_string_view& other) noexcept -> filtered_string_view&;
+		constexpr auto operator=(const basic_filtered_string_view& other) noexcept -> basic_filtered_string_view& {
+			if (this != &other) {
+				strptr_ = other.strptr_;
+				length_ = other.length_;
+				remember_size(other.remembered_size());
+				predicate_ = other.predicate_;
+				index_ = other.index_;
+				runs_ = other.runs_;
+			}
+			return *this;
+		}
 
 		// move assignment
-		auto operator=(filtered_string_view&& other) noexcept -> filtered_string_view&;
+		constexpr auto operator=(basic_filtered_string_view&& other) noexcept -> basic_filtered_string_view& {
+			if (this != &other) {
+				auto moved = basic_filtered_string_view{std::move(other)};
+				swap(moved);
+			}
+			return *this;
+		}
 
 		// subscript
-		auto operator[](int n) const -> const char&;
+		constexpr auto operator[](int n) const -> const char& {
+			return at(n);
+		}
+
+		constexpr explicit operator std::string() const {
+			return filter_string();
+		}
+
+		// copies up to count kept characters, from the pos-th on, to dest and returns how many were copied
+		constexpr auto copy(char* dest, std::size_t count = npos, std::size_t pos = 0) const -> std::size_t {
+			auto const size = this->size();
+			if (pos > size) {
+				throw std::domain_error{"filtered_string_view::copy(" + std::to_string(pos) + "): invalid position"};
+			}
+			auto const rcount = std::min(count, size - pos);
+			auto const first = kept_offset(pos);
+			auto const last = pos + rcount == size ? length_ : kept_offset(pos + rcount);
+			if (not runs_.empty()) {
+				kept_runs().for_each_run(first, last, [this, &dest](std::size_t run_first, std::size_t run_last) {
+					dest = std::copy_n(strptr_ + run_first, run_last - run_first, dest);
+				});
+			}
+			else {
+				detail::copy_kept_by(strptr_ + first, last - first, predicate_.get(), dest);
+			}
+			return rcount;
+		}
+
+		constexpr auto at(int index) const -> const char& {
+			if (not index_.empty()) {
+				auto const& positions = positions_index();
+				if (index >= 0 and static_cast<std::size_t>(index) < positions.size()) {
+					return strptr_[positions.select(static_cast<std::size_t>(index))];
+				}
+			}
+			else if (not runs_.empty()) {
+				auto const& runs = kept_runs();
+				if (index >= 0 and static_cast<std::size_t>(index) < runs.size()) {
+					return strptr_[runs.offset(static_cast<std::size_t>(index))];
+				}
+			}
+			else if (index >= 0) {
+				auto kept = 0;
+				for (auto p = strptr_; p != strptr_ + length_; ++p) {
+					if (predicate_.get()(*p) and kept++ == index) {
+						return *p;
+					}
+				}
+			}
+			throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
+		}
 
-		explicit operator std::string() const;
+		// the filtered length is computed at most once per view (and its copies) and then remembered
+		constexpr auto size() const -> std::size_t {
+			auto size = remembered_size();
+			if (size == unknown_length) {
+				if (not index_.empty()) {
+					size = positions_index().size();
+				}
+				else if (not runs_.empty()) {
+					size = kept_runs().size();
+				}
+				else {
+					size = find_filtered_str_length();
+				}
+				remember_size(size);
+			}
+			return size;
+		}
 
-		auto at(int index) const -> const char&;
+		constexpr auto empty() const -> bool {
+			auto const size = remembered_size();
+			if (size != unknown_length) {
+				return size == 0;
+			}
+			return std::none_of(strptr_, strptr_ + length_, std::cref(predicate_.get()));
+		}
 
-		auto size() const -> size_t;
+		constexpr auto data() const noexcept -> const char* {
+			return strptr_;
+		}
 
-		auto empty() const -> bool;
+		constexpr auto predicate() const noexcept -> const Pred& {
+			return predicate_.get();
+		}
 
-		auto data() const noexcept -> const char*;
+		// returns a copy of this view which builds an index of the kept positions on its first random access
+		// (operator[], at, size, substr), after which those are O(1) or O(log n). copies share the index.
+		auto with_index() const -> basic_filtered_string_view {
+			auto indexed = *this;
+			indexed.index_ = detail::shared_slot<detail::position_index>::make();
+			return indexed;
+		}
 
-		auto predicate() const noexcept -> const filter&;
+		constexpr auto has_index() const noexcept -> bool {
+			return not index_.empty();
+		}
 
-		friend auto operator<=>(const filtered_string_view& lhs, const filtered_string_view& rhs) -> std::strong_ordering;
+		// returns a copy of this view which finds the runs of consecutive kept characters on first use, after
+		// which conversion to std::string, operator<<, copy(), comparisons and substr() work a run at a time,
+		// at close to the speed of a plain copy when the predicate keeps long runs (say, one which drops
+		// control characters). copies share the runs.
+		auto with_runs() const -> basic_filtered_string_view {
+			auto with = *this;
+			with.runs_ = detail::shared_slot<detail::run_list>::make();
+			return with;
+		}
 
-		friend auto operator==(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
+		constexpr auto has_runs() const noexcept -> bool {
+			return not runs_.empty();
+		}
 
-		friend auto operator!=(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
+		// calls fn(run, count) with every maximal run of consecutive kept characters, in order and in place in
+		// the underlying string, for output which can take the characters where they are (see write_to)
+		template<typename Fn>
+		auto for_each_run(Fn fn) const -> void {
+			if (has_runs()) {
+				for (auto const& run : kept_runs().runs()) {
+					fn(strptr_ + run.first, run.last - run.first);
+				}
+			}
+			else {
+				detail::for_each_kept_run(strptr_, length_, predicate_.get(), fn);
+			}
+		}
 
-		friend auto operator<(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
+		// calls fn(kept, count) with the kept characters in order, in blocks which may be in a buffer that is
+		// only valid during the call: the runs when the view has them, the whole range when everything is
+		// kept, the blocks of the char_class kernels, or batches of up to 256 characters otherwise. cheaper
+		// than for_each_run for output which copies the characters anyway.
+		template<typename Fn>
+		auto for_each_block(Fn fn) const -> void {
+			if (has_runs()) {
+				for_each_run(fn);
+			}
+			else {
+				detail::for_each_kept_block_by(strptr_, length_, predicate_.get(), fn);
+			}
+		}
 
-		friend auto operator>(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
+		static constexpr auto npos = static_cast<std::size_t>(-1);
 
-		friend auto operator<=(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
+		// position of the first occurrence of needle in the filtered string at or after pos, or npos
+		auto find(std::string_view needle, std::size_t pos = 0) const -> std::size_t {
+			if (needle.empty()) {
+				return pos <= size() ? pos : npos;
+			}
+			auto const from = strptr_ + kept_offset(pos);
+			auto const match = search(from, strptr_ + length_, needle, detail::horspool_table{needle});
+			return match.found ? pos + match.skipped : npos;
+		}
 
-		friend auto operator>=(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
+		template<char_predicate Other>
+		auto find(const basic_filtered_string_view<Other>& needle, std::size_t pos = 0) const -> std::size_t {
+			return find(std::string_view{static_cast<std::string>(needle)}, pos);
+		}
 
-		friend auto operator<<(std::ostream& os, const filtered_string_view& fsv) -> std::ostream&;
+		// position of the last occurrence of needle in the filtered string starting at or before pos, or npos
+		auto rfind(std::string_view needle, std::size_t pos = npos) const -> std::size_t {
+			auto const size = this->size();
+			if (needle.size() > size) {
+				return npos;
+			}
+			auto const start = std::min(pos, size - needle.size());
+			if (needle.empty()) {
+				return start;
+			}
+			// search backwards from the end of the last possible match, with the needle reversed
+			auto const reversed = std::views::reverse(needle);
+			auto const limit = strptr_ + kept_offset(start + needle.size());
+			auto const match = search(std::make_reverse_iterator(limit),
+			                          std::make_reverse_iterator(strptr_),
+			                          reversed,
+			                          detail::horspool_table{reversed});
+			return match.found ? start - match.skipped : npos;
+		}
+
+		template<char_predicate Other>
+		auto rfind(const basic_filtered_string_view<Other>& needle, std::size_t pos = npos) const -> std::size_t {
+			return rfind(std::string_view{static_cast<std::string>(needle)}, pos);
+		}
+
+		auto contains(std::string_view needle) const -> bool {
+			return find(needle) != npos;
+		}
+
+		template<char_predicate Other>
+		auto contains(const basic_filtered_string_view<Other>& needle) const -> bool {
+			return find(needle) != npos;
+		}
+
+		auto starts_with(std::string_view prefix) const -> bool {
+			auto p = strptr_;
+			auto const end = strptr_ + length_;
+			for (auto const c : prefix) {
+				p = std::find_if(p, end, std::cref(predicate_.get()));
+				if (p == end or *p != c) {
+					return false;
+				}
+				++p;
+			}
+			return true;
+		}
+
+		template<char_predicate Other>
+		auto starts_with(const basic_filtered_string_view<Other>& prefix) const -> bool {
+			return starts_with(std::string_view{static_cast<std::string>(prefix)});
+		}
+
+		auto ends_with(std::string_view suffix) const -> bool {
+			auto p = std::make_reverse_iterator(strptr_ + length_);
+			auto const rend = std::make_reverse_iterator(strptr_);
+			for (auto const c : std::views::reverse(suffix)) {
+				p = std::find_if(p, rend, std::cref(predicate_.get()));
+				if (p == rend or *p != c) {
+					return false;
+				}
+				++p;
+			}
+			return true;
+		}
+
+		template<char_predicate Other>
+		auto ends_with(const basic_filtered_string_view<Other>& suffix) const -> bool {
+			return ends_with(std::string_view{static_cast<std::string>(suffix)});
+		}
+
+		friend constexpr auto operator<=>(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> std::strong_ordering {
+			return compare(lhs, rhs);
+		}
+
+		friend constexpr auto operator==(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> bool {
+			// views whose sizes are already known and differ cannot be equal
+			auto const lsize = lhs.remembered_size();
+			auto const rsize = rhs.remembered_size();
+			if (lsize != unknown_length and rsize != unknown_length and lsize != rsize) {
+				return false;
+			}
+			return compare(lhs, rhs) == 0;
+		}
+
+		friend constexpr auto operator!=(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> bool {
+			return not(lhs == rhs);
+		}
+
+		friend constexpr auto operator<(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> bool {
+			return (lhs <=> rhs) < 0;
+		}
+
+		friend constexpr auto operator>(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> bool {
+			return (lhs <=> rhs) > 0;
+		}
+
+		friend constexpr auto operator<=(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> bool {
+			return (lhs <=> rhs) <= 0;
+		}
+
+		friend constexpr auto operator>=(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> bool {
+			return (lhs <=> rhs) >= 0;
+		}
+
+		friend auto operator<<(std::ostream& os, const basic_filtered_string_view& fsv) -> std::ostream& {
+			return detail::insert_kept(os, fsv);
+		}
 
 	 private:
+		static constexpr auto unknown_length = static_cast<std::size_t>(-1);
+
+		// views over a raw [str, str + length) range, used by the non-member utilities, which often already
+		// know how many characters are kept
+		constexpr basic_filtered_string_view(const char* str,
+		                                     std::size_t length,
+		                                     detail::predicate_handle<Pred> predicate,
+		                                     std::size_t filtered_length = unknown_length) noexcept
+		: strptr_{str}
+		, length_{length}
+		, filtered_length_{std::is_constant_evaluated() ? unknown_length : length == 0 ? 0 : filtered_length}
+		, predicate_{std::move(predicate)} {}
+
+		// views without a predicate of their own share a single default one, unless it is stored inline
+		static constexpr auto default_handle() -> detail::predicate_handle<Pred> {
+			if constexpr (std::same_as<detail::predicate_handle<Pred>, detail::predicate_box<Pred>>) {
+				return detail::predicate_handle<Pred>{Pred{true_predicate{}}};
+			}
+			else {
+				return shared_default_handle();
+			}
+		}
+
+		static auto shared_default_handle() -> const detail::predicate_handle<Pred>& {
+			static auto const handle = detail::predicate_handle<Pred>{Pred{true_predicate{}}};
+			return handle;
+		}
+
 		const char* strptr_;
 		std::size_t length_;
-		filter predicate_;
+		mutable std::atomic<std::size_t> filtered_length_;
+		detail::predicate_handle<Pred> predicate_;
+		detail::shared_slot<detail::position_index> index_;
+		detail::shared_slot<detail::run_list> runs_;
+
+		// the remembered size, or unknown_length. views made in constant expressions, where atomics cannot
+		// be used, start with an unknown size and never remember one, so they stay correct when used at runtime.
+		constexpr auto remembered_size() const noexcept -> std::size_t {
+			if (std::is_constant_evaluated()) {
+				return unknown_length;
+			}
+			return filtered_length_.load(std::memory_order_relaxed);
+		}
+
+		// racing const callers compute the same value, so a relaxed store is enough
+		constexpr auto remember_size(std::size_t size) const noexcept -> void {
+			if (not std::is_constant_evaluated()) {
+				filtered_length_.store(size, std::memory_order_relaxed);
+			}
+		}
+
+		auto positions_index() const -> const detail::position_index& {
+			return index_.get(strptr_, length_, predicate_.get());
+		}
+
+		auto kept_runs() const -> const detail::run_list& {
+			return runs_.get(strptr_, length_, predicate_.get());
+		}
+
+		// raw offset of the pos-th kept character, or length_ if there is none
+		constexpr auto kept_offset(std::size_t pos) const -> std::size_t {
+			if (not index_.empty()) {
+				auto const& positions = positions_index();
+				return pos < positions.size() ? positions.select(pos) : length_;
+			}
+			if (not runs_.empty()) {
+				return kept_runs().offset(pos);
+			}
+			auto const first = std::next(begin(), static_cast<std::ptrdiff_t>(pos));
+			return first == end() ? length_ : static_cast<std::size_t>(&*first - strptr_);
+		}
+
+		// whether the predicate is known to keep every character, as the default one does
+		constexpr auto keeps_everything() const noexcept -> bool {
+			return detail::keeps_everything(predicate_.get());
+		}
 
-		auto find_filtered_str_length() const -> std::size_t;
+		// Horspool search for needle among the kept characters of [first, last), which lie within this view
+		template<typename It, typename Needle>
+		constexpr auto search(It first, It last, const Needle& needle, const detail::horspool_table& table) const
+		    -> detail::kept_search_result<It> {
+			if (keeps_everything()) {
+				return detail::horspool_search(first, last, true_predicate{}, needle, table);
+			}
+			return detail::horspool_search(first, last, predicate_.get(), needle, table);
+		}
 
-		auto swap(filtered_string_view& other) noexcept -> void;
+		// the char_class behind the predicate, if there is one, so that scans can use the vectorised kernels
+		constexpr auto char_class_predicate() const noexcept -> const char_class* {
+			return detail::char_class_of(predicate_.get());
+		}
 
-		auto filter_string() const -> std::string;
+		// a reader of the kept characters a block at a time, if there is one cheaper than calling the predicate
+		// per character: over the runs, the whole range, or through the char_class kernels
+		auto block_reader() const -> std::optional<detail::kept_block_reader> {
+			if (has_runs()) {
+				return detail::kept_block_reader{strptr_, kept_runs().runs()};
+			}
+			if (keeps_everything()) {
+				return detail::kept_block_reader{strptr_, length_, nullptr};
+			}
+			if (auto const* cls = char_class_predicate()) {
+				return detail::kept_block_reader{strptr_, length_, cls};
+			}
+			return std::nullopt;
+		}
+
+		// compares the kept characters without building strings. views over the same range with the same
+		// predicate (copies of each other, for one) are equal without reading anything, and views with runs
+		// are compared a run at a time.
+		static constexpr auto compare(const basic_filtered_string_view& lhs, const basic_filtered_string_view& rhs)
+		    -> std::strong_ordering {
+			if (lhs.strptr_ == rhs.strptr_ and lhs.length_ == rhs.length_
+			    and ((lhs.keeps_everything() and rhs.keeps_everything())
+			         or detail::same_predicate(lhs.predicate_, rhs.predicate_)))
+			{
+				return std::strong_ordering::equal;
+			}
+			if (lhs.has_runs() or rhs.has_runs()) {
+				auto lreader = lhs.block_reader();
+				auto rreader = rhs.block_reader();
+				if (lreader and rreader) {
+					return detail::compare_blocks(*lreader, *rreader);
+				}
+			}
+			return detail::compare_kept(lhs.strptr_,
+			                            lhs.length_,
+			                            lhs.predicate_.get(),
+			                            rhs.strptr_,
+			                            rhs.length_,
+			                            rhs.predicate_.get());
+		}
+
+		constexpr auto find_filtered_str_length() const -> std::size_t {
+			return detail::count_kept_by(strptr_, length_, predicate_.get());
+		}
+
+		constexpr auto swap(basic_filtered_string_view& other) noexcept -> void {
+			std::swap(strptr_, other.strptr_);
+			std::swap(length_, other.length_);
+			auto const size = remembered_size();
+			remember_size(other.remembered_size());
+			other.remember_size(size);
+			std::swap(predicate_, other.predicate_);
+			std::swap(index_, other.index_);
+			std::swap(runs_, other.runs_);
+		}
+
+		constexpr auto filter_string() const -> std::string {
+			if (keeps_everything()) {
+				return std::string(strptr_, length_);
+			}
+			auto str = std::string{};
+			if (has_runs()) {
+				auto const& runs = kept_runs();
+				str.reserve(runs.size());
+				for (auto const& run : runs.runs()) {
+					str.append(strptr_ + run.first, run.last - run.first);
+				}
+				return str;
+			}
+			if (auto const size = remembered_size(); size != unknown_length) {
+				str.reserve(size);
+			}
+			if (auto const* cls = char_class_predicate()) {
+				detail::for_each_kept_block(strptr_, length_, *cls, [&str](const char* kept, std::size_t count) {
+					str.append(kept, count);
+				});
+				return str;
+			}
+			std::copy_if(strptr_, strptr_ + length_, std::back_inserter(str), std::cref(predicate_.get()));
+			return str;
+		}
+
+		template<char_predicate>
+		friend class basic_filtered_string_view;
+
+		template<char_predicate>
+		friend class split_view;
+
+		template<char_predicate>
+		friend class basic_indexed_view;
+
+		friend class multi_matcher;
+		friend struct hash;
+		friend struct equal_to;
+
+		template<char_predicate P>
+		friend auto compose(const basic_filtered_string_view<P>& fsv, const std::vector<filter>& filts) noexcept
+		    -> filtered_string_view;
+
+		template<char_predicate P, char_predicate... Ps>
+		requires(sizeof...(Ps) > 0)
+		friend auto compose(const basic_filtered_string_view<P>& fsv, Ps... preds)
+		    -> basic_filtered_string_view<detail::composed_predicate_t<Ps...>>;
+
+		template<char_predicate P>
+		friend constexpr auto substr(const basic_filtered_string_view<P>& fsv, int pos, int count)
+		    -> basic_filtered_string_view<P>;
+
+		template<char_predicate P>
+		friend auto size(const parallel& policy, const basic_filtered_string_view<P>& fsv) -> std::size_t;
+
+		template<char_predicate P, char_predicate TokP>
+		friend auto split(const parallel& policy,
+		                  const basic_filtered_string_view<P>& fsv,
+		                  const basic_filtered_string_view<TokP>& tok) -> std::vector<basic_filtered_string_view<P>>;
+
+		template<char_predicate P>
+		friend auto to_string(const parallel& policy, const basic_filtered_string_view<P>& fsv) -> std::string;
 	};
 
-	// non-member utility functions
-	auto compose(const filtered_string_view& fsv, const std::vector<filter>& filts) noexcept -> filtered_string_view;
+	template<char_predicate Pred>
+	basic_filtered_string_view(const char*, Pred) -> basic_filtered_string_view<Pred>;
+
+	template<char_predicate Pred>
+	basic_filtered_string_view(const char*, std::size_t, Pred) -> basic_filtered_string_view<Pred>;
+
+	template<char_predicate Pred>
+	basic_filtered_string_view(const std::string&, Pred) -> basic_filtered_string_view<Pred>;
+
+	template<char_predicate Pred>
+	basic_filtered_string_view(std::string_view, Pred) -> basic_filtered_string_view<Pred>;
+
+	template<char_predicate Pred>
+	auto compose(const basic_filtered_string_view<Pred>& fsv, const std::vector<filter>& filts) noexcept
+	    -> filtered_string_view {
+		// the predicate of fsv itself is not applied, only the ones in filts, in order
+		return filtered_string_view{fsv.strptr_,
+		                            fsv.length_,
+		                            detail::predicate_handle<filter>{detail::fuse_filters(filts)}};
+	}
+
+	// like compose() over a list of filters, but with the predicates known statically: they are inlined into
+	// a single conjunction, or fused into one table when they are all char_classes
+	template<char_predicate Pred, char_predicate... Preds>
+	requires(sizeof...(Preds) > 0)
+	auto compose(const basic_filtered_string_view<Pred>& fsv, Preds... preds)
+	    -> basic_filtered_string_view<detail::composed_predicate_t<Preds...>> {
+		using composed = detail::composed_predicate_t<Preds...>;
+		if constexpr (std::same_as<composed, char_class>) {
+			return basic_filtered_string_view<composed>{fsv.strptr_,
+			                                            fsv.length_,
+			                                            detail::predicate_handle<composed>{(preds & ...)}};
+		}
+		else {
+			return basic_filtered_string_view<composed>{fsv.strptr_,
+			                                            fsv.length_,
+			                                            detail::predicate_handle<composed>{composed{std::move(preds)...}}};
+		}
+	}
+
+	// a lazy range over the pieces of split(fsv, tok). each piece is found when an iterator reaches it, so
+	// walking the pieces allocates nothing
+	template<char_predicate Pred>
+	class split_view : public std::ranges::view_interface<split_view<Pred>> {
+		class iter {
+		 public:
+			using iterator_concept = std::forward_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using value_type = basic_filtered_string_view<Pred>;
+			using difference_type = std::ptrdiff_t;
+
+			iter() noexcept = default;
+
+			constexpr auto operator*() const -> value_type {
+				// pieces share the predicate of the split view
+				return value_type{piece_first_,
+				                  static_cast<std::size_t>(piece_last_ - piece_first_),
+				                  parent_->fsv_.predicate_,
+				                  piece_size_};
+			}
+
+			constexpr auto operator++() -> iter& {
+				if (last_piece_) {
+					done_ = true;
+				}
+				else {
+					parent_->find_piece(*this, next_);
+				}
+				return *this;
+			}
+
+			constexpr auto operator++(int) -> iter {
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			friend constexpr auto operator==(const iter& lhs, const iter& rhs) noexcept -> bool {
+				return lhs.done_ == rhs.done_ and (lhs.done_ or lhs.piece_first_ == rhs.piece_first_);
+			}
+
+			friend constexpr auto operator==(const iter& it, std::default_sentinel_t) noexcept -> bool {
+				return it.done_;
+			}
+
+		 private:
+			const split_view* parent_ = nullptr;
+			const char* piece_first_ = nullptr;
+			const char* piece_last_ = nullptr;
+			// where the search for the next piece starts, just past the token ending this piece
+			const char* next_ = nullptr;
+			std::size_t piece_size_ = 0;
+			bool last_piece_ = true;
+			bool done_ = true;
+
+			friend class split_view;
+		};
+
+	 public:
+		template<char_predicate TokPred>
+		constexpr split_view(basic_filtered_string_view<Pred> fsv, const basic_filtered_string_view<TokPred>& tok)
+		: fsv_{std::move(fsv)}
+		, needle_(tok.begin(), tok.end())
+		, table_{needle_} {}
+
+		// splits on the characters of needle, which is not filtered
+		constexpr split_view(basic_filtered_string_view<Pred> fsv, std::string needle)
+		: fsv_{std::move(fsv)}
+		, needle_{std::move(needle)}
+		, table_{needle_} {}
+
+		constexpr auto begin() const -> iter {
+			auto it = iter{};
+			it.parent_ = this;
+			it.done_ = false;
+			if (needle_.empty() or fsv_.empty()) {
+				// the only piece is fsv itself
+				it.piece_first_ = fsv_.strptr_;
+				it.piece_last_ = fsv_.strptr_ + fsv_.length_;
+				it.piece_size_ = fsv_.size();
+			}
+			else {
+				find_piece(it, fsv_.strptr_);
+			}
+			return it;
+		}
+
+		constexpr auto end() const noexcept -> std::default_sentinel_t {
+			return std::default_sentinel;
+		}
+
+	 private:
+		constexpr auto find_piece(iter& it, const char* from) const -> void {
+			auto const end = fsv_.strptr_ + fsv_.length_;
+			auto const match = fsv_.search(from, end, needle_, table_);
+			it.piece_first_ = from;
+			it.piece_last_ = match.first;
+			it.piece_size_ = match.skipped;
+			it.next_ = match.found ? match.last + 1 : end;
+			it.last_piece_ = not match.found;
+		}
+
+		basic_filtered_string_view<Pred> fsv_;
+		std::string needle_;
+		detail::horspool_table table_;
+	};
+
+	template<char_predicate Pred, char_predicate TokPred>
+	constexpr auto split(const basic_filtered_string_view<Pred>& fsv, const basic_filtered_string_view<TokPred>& tok)
+	    -> std::vector<basic_filtered_string_view<Pred>> {
+		auto result = std::vector<basic_filtered_string_view<Pred>>{};
+		for (auto&& piece : split_view<Pred>{fsv, tok}) {
+			result.push_back(std::move(piece));
+		}
+		return result;
+	}
+
+	// writes the pieces of split(fsv, tok) into out and returns how many pieces there are, which is more than
+	// out.size() when out is too small to hold them all
+	template<char_predicate Pred, char_predicate TokPred>
+	constexpr auto split(const basic_filtered_string_view<Pred>& fsv,
+	                     const basic_filtered_string_view<TokPred>& tok,
+	                     std::type_identity_t<std::span<basic_filtered_string_view<Pred>>> out) -> std::size_t {
+		auto count = std::size_t{0};
+		for (auto&& piece : split_view<Pred>{fsv, tok}) {
+			if (count < out.size()) {
+				out[count] = std::move(piece);
+			}
+			++count;
+		}
+		return count;
+	}
+
+	template<char_predicate Pred>
+	constexpr auto substr(const basic_filtered_string_view<Pred>& fsv, int pos, int count)
+	    -> basic_filtered_string_view<Pred> {
+		auto const size = static_cast<int>(fsv.size());
+		pos = std::clamp(pos, 0, size);
+		auto const rcount = count <= 0 ? size - pos : std::min(count, size - pos);
+
+		auto const raw_first = fsv.kept_offset(static_cast<std::size_t>(pos));
+		auto const raw_last = fsv.kept_offset(static_cast<std::size_t>(pos + rcount));
+		return basic_filtered_string_view<Pred>{fsv.strptr_ + raw_first,
+		                                        raw_last - raw_first,
+		                                        fsv.predicate_,
+		                                        static_cast<std::size_t>(rcount)};
+	}
+
+	// size(), with the kept characters counted in parallel. the result is remembered like size()'s.
+	template<char_predicate Pred>
+	auto size(const parallel& policy, const basic_filtered_string_view<Pred>& fsv) -> std::size_t {
+		auto const n = detail::parallel_chunks(policy, fsv.length_);
+		if (n == 1 or fsv.remembered_size() != fsv.unknown_length) {
+			return fsv.size();
+		}
+		auto counts = std::vector<std::size_t>(n);
+		detail::parallel_for(n, [&](std::size_t i) {
+			auto const first = detail::chunk_offset(fsv.length_, i, n);
+			auto const last = detail::chunk_offset(fsv.length_, i + 1, n);
+			counts[i] = detail::count_kept_by(fsv.strptr_ + first, last - first, fsv.predicate_.get());
+		});
+		auto const size = std::reduce(counts.begin(), counts.end());
+		fsv.remember_size(size);
+		return size;
+	}
+
+	// static_cast<std::string>(fsv), built in parallel: each thread counts the kept characters of its chunk,
+	// an exclusive prefix sum of the counts gives where each chunk goes in the string, and then each
+	// thread copies its kept characters there
+	template<char_predicate Pred>
+	auto to_string(const parallel& policy, const basic_filtered_string_view<Pred>& fsv) -> std::string {
+		auto const n = detail::parallel_chunks(policy, fsv.length_);
+		if (n == 1) {
+			return static_cast<std::string>(fsv);
+		}
+		auto const chunk = [&fsv, n](std::size_t i) {
+			auto const first = detail::chunk_offset(fsv.length_, i, n);
+			auto const last = detail::chunk_offset(fsv.length_, i + 1, n);
+			return std::pair{fsv.strptr_ + first, last - first};
+		};
+
+		auto offsets = std::vector<std::size_t>(n);
+		if (fsv.keeps_everything()) {
+			for (auto i = std::size_t{0}; i < n; ++i) {
+				offsets[i] = detail::chunk_offset(fsv.length_, i, n);
+			}
+		}
+		else {
+			detail::parallel_for(n, [&](std::size_t i) {
+				auto const [first, length] = chunk(i);
+				offsets[i] = detail::count_kept_by(first, length, fsv.predicate_.get());
+			});
+			auto const last_count = offsets.back();
+			std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), std::size_t{0});
+			fsv.remember_size(offsets.back() + last_count);
+		}
+
+		return detail::string_for_overwrite(fsv.size(), [&](char* out) {
+			detail::parallel_for(n, [&](std::size_t i) {
+				auto const [first, length] = chunk(i);
+				detail::copy_kept_by(first, length, fsv.predicate_.get(), out + offsets[i]);
+			});
+		});
+	}
+
+	// split(fsv, tok), with the token searched for in parallel. each thread finds every occurrence of the
+	// token which starts in its chunk, overlapping ones included, since which of them are tokens depends on
+	// where the tokens of the chunks before end. a sequential pass then takes, in order, each occurrence
+	// starting after the last one taken ends, which are the tokens the sequential search finds.
+	template<char_predicate Pred, char_predicate TokPred>
+	auto split(const parallel& policy,
+	           const basic_filtered_string_view<Pred>& fsv,
+	           const basic_filtered_string_view<TokPred>& tok) -> std::vector<basic_filtered_string_view<Pred>> {
+		auto const needle = static_cast<std::string>(tok);
+		auto const n = detail::parallel_chunks(policy, fsv.length_);
+		if (n == 1 or needle.empty() or fsv.empty()) {
+			return split(fsv, tok);
+		}
+
+		struct occurrence {
+			const char* first;
+			const char* last;
+			std::size_t pos; // kept characters before first in its chunk
+		};
+		auto const& pred = fsv.predicate_.get();
+		auto const table = detail::horspool_table{needle};
+		auto const end = fsv.strptr_ + fsv.length_;
+		auto occurrences = std::vector<std::vector<occurrence>>(n);
+		auto counts = std::vector<std::size_t>(n);
+		detail::parallel_for(n, [&](std::size_t i) {
+			auto const first = fsv.strptr_ + detail::chunk_offset(fsv.length_, i, n);
+			auto const last = fsv.strptr_ + detail::chunk_offset(fsv.length_, i + 1, n);
+			counts[i] = detail::count_kept_by(first, static_cast<std::size_t>(last - first), pred);
+
+			// an occurrence starting in the chunk ends at most needle.size() - 1 kept characters past it
+			auto limit = last;
+			for (auto k = needle.size() - 1; k > 0 and limit != end; --k) {
+				limit = std::find_if(limit, end, std::cref(pred));
+				if (limit != end) {
+					++limit;
+				}
+			}
+			auto from = first;
+			auto pos = std::size_t{0};
+			while (true) {
+				auto const match = fsv.search(from, limit, needle, table);
+				if (not match.found or match.first >= last) {
+					break;
+				}
+				pos += match.skipped;
+				occurrences[i].push_back({match.first, match.last, pos});
+				from = match.first + 1;
+				++pos;
+			}
+		});
+
+		auto result = std::vector<basic_filtered_string_view<Pred>>{};
+		auto piece_first = fsv.strptr_;
+		auto piece_pos = std::size_t{0}; // kept characters before piece_first
+		auto chunk_pos = std::size_t{0}; // kept characters before the chunk
+		for (auto i = std::size_t{0}; i < n; ++i) {
+			for (auto const& occ : occurrences[i]) {
+				auto const pos = chunk_pos + occ.pos;
+				if (pos >= piece_pos) {
+					result.push_back(basic_filtered_string_view<Pred>{piece_first,
+					                                                  static_cast<std::size_t>(occ.first - piece_first),
+					                                                  fsv.predicate_,
+					                                                  pos - piece_pos});
+					piece_first = occ.last + 1;
+					piece_pos = pos + needle.size();
+				}
+			}
+			chunk_pos += counts[i];
+		}
+		result.push_back(basic_filtered_string_view<Pred>{piece_first,
+		                                                  static_cast<std::size_t>(end - piece_first),
+		                                                  fsv.predicate_,
+		                                                  chunk_pos - piece_pos});
+		return result;
+	}
+
+	// copies the kept characters of every view one after the other into a single block allocated from arena
+	// (a std::pmr::monotonic_buffer_resource, typically) and returns where each one went. the strings live
+	// as long as the arena does.
+	template<char_predicate... Preds>
+	auto materialize_into(std::pmr::memory_resource& arena, const basic_filtered_string_view<Preds>&... views)
+	    -> std::array<std::string_view, sizeof...(Preds)> {
+		auto const total = (std::size_t{0} + ... + views.size());
+		auto* out = total == 0 ? nullptr : static_cast<char*>(arena.allocate(total, alignof(char)));
+		auto const place = [&out](const auto& view) {
+			auto const first = out;
+			out += view.copy(out);
+			return std::string_view{first, static_cast<std::size_t>(out - first)};
+		};
+		return {place(views)...};
+	}
+
+	// as above for a range of views, such as the result of split(); the string_views are kept in a vector
+	// allocated from arena too. the range is walked twice, once to size the block and once to fill it.
+	template<std::ranges::forward_range Views>
+	requires detail::is_filtered_view<std::ranges::range_value_t<Views>>
+	auto materialize_into(std::pmr::memory_resource& arena, const Views& views) -> std::pmr::vector<std::string_view> {
+		auto result = std::pmr::vector<std::string_view>{&arena};
+		if constexpr (std::ranges::sized_range<Views>) {
+			result.reserve(std::ranges::size(views));
+		}
+		auto total = std::size_t{0};
+		for (auto const& view : views) {
+			total += view.size();
+		}
+		auto* out = total == 0 ? nullptr : static_cast<char*>(arena.allocate(total, alignof(char)));
+		for (auto const& view : views) {
+			auto const first = out;
+			out += view.copy(out);
+			result.emplace_back(first, static_cast<std::size_t>(out - first));
+		}
+		return result;
+	}
+
+	// split(fsv, tok) with the pieces copied one after the other into a single block allocated from arena,
+	// which holds the string_views too, so that tokenizing allocates from the heap only when the arena does
+	template<char_predicate Pred, char_predicate TokPred>
+	auto split(std::pmr::memory_resource& arena,
+	           const basic_filtered_string_view<Pred>& fsv,
+	           const basic_filtered_string_view<TokPred>& tok) -> std::pmr::vector<std::string_view> {
+		auto result = std::pmr::vector<std::string_view>{&arena};
+		// the pieces hold every kept character but those of the tokens, so fsv.size() is enough for them
+		auto const capacity = fsv.size();
+		auto* out = capacity == 0 ? nullptr : static_cast<char*>(arena.allocate(capacity, alignof(char)));
+		for (auto&& piece : split_view<Pred>{fsv, tok}) {
+			auto const first = out;
+			out += piece.copy(out);
+			result.emplace_back(first, static_cast<std::size_t>(out - first));
+		}
+		return result;
+	}
+
+	namespace detail {
+		// puts the kept characters of fsv into buf with one sputn() per block of kept characters: a run at a
+		// time for views with runs, and otherwise the whole range, the blocks of the char_class kernels or
+		// batches of up to 256 characters. returns whether buf took them all.
+		template<char_predicate Pred>
+		auto put_kept(std::streambuf& buf, const basic_filtered_string_view<Pred>& fsv) -> bool {
+			auto good = true;
+			fsv.for_each_block([&buf, &good](const char* kept, std::size_t count) {
+				auto const n = static_cast<std::streamsize>(count);
+				good = good and buf.sputn(kept, n) == n;
+			});
+			return good;
+		}
+
+		// puts count copies of fill into buf, returning whether buf took them all
+		inline auto put_fill(std::streambuf& buf, char fill, std::size_t count) -> bool {
+			using traits = std::char_traits<char>;
+			for (; count != 0; --count) {
+				if (traits::eq_int_type(buf.sputc(fill), traits::eof())) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// operator<<, a formatted inserter like std::string_view's whatever the predicate: the kept characters
+		// go through put_kept(), padded with os.fill() to os.width() on the side adjustfield says, and the
+		// width is reset for the next insertion
+		template<char_predicate Pred>
+		auto insert_kept(std::ostream& os, const basic_filtered_string_view<Pred>& fsv) -> std::ostream& {
+			auto const sentry = std::ostream::sentry{os};
+			if (sentry) {
+				auto const width = static_cast<std::size_t>(std::max(os.width(), std::streamsize{0}));
+				auto const padding = width == 0 ? 0 : width - std::min(width, fsv.size());
+				auto const left = (os.flags() & std::ios_base::adjustfield) == std::ios_base::left;
+				auto& buf = *os.rdbuf();
+				auto const good = (left or put_fill(buf, os.fill(), padding)) and put_kept(buf, fsv)
+				                  and (not left or put_fill(buf, os.fill(), padding));
+				os.width(0);
+				if (not good) {
+					os.setstate(std::ios_base::badbit);
+				}
+			}
+			return os;
+		}
+	} // namespace detail
+
+	// writes the kept characters of fsv to os unformatted, like os.write(), a block at a time (see
+	// detail::put_kept). sets badbit if the stream buffer takes less.
+	template<char_predicate Pred>
+	auto write_to(std::ostream& os, const basic_filtered_string_view<Pred>& fsv) -> std::ostream& {
+		auto const sentry = std::ostream::sentry{os};
+		if (sentry and not detail::put_kept(*os.rdbuf(), fsv)) {
+			os.setstate(std::ios_base::badbit);
+		}
+		return os;
+	}
+
+	// writes the kept characters of every view in turn, each followed by separator
+	template<std::ranges::input_range Views>
+	requires detail::is_filtered_view<std::ranges::range_value_t<Views>>
+	auto write_to(std::ostream& os, const Views& views, std::string_view separator) -> std::ostream& {
+		for (auto const& view : views) {
+			if (not write_to(os, view).write(separator.data(), static_cast<std::streamsize>(separator.size()))) {
+				break;
+			}
+		}
+		return os;
+	}
+
+	// what from_chars() read from a view: the number of kept characters which make up the number, and the
+	// error, as with std::from_chars
+	struct from_chars_result {
+		std::size_t count;
+		std::errc ec;
+
+		friend auto operator==(const from_chars_result&, const from_chars_result&) -> bool = default;
+	};
+
+	namespace detail {
+		// every character std::from_chars can read as part of a number, in any base or format
+		inline constexpr auto number_chars = char_class::alnum() | char_class{"+-._()"};
+
+		// parses value with parse(first, last, value), which returns a std::from_chars_result, from the kept
+		// characters of fsv: in place when nothing is filtered out, and otherwise from the longest prefix of
+		// kept characters which could be part of a number, gathered into a buffer on the stack. the rest of
+		// that prefix is only gathered into a string, from the default memory resource, when cut_short(stop,
+		// last) says that the end of the buffer may have stopped the parse at stop, as it does for numbers
+		// longer than the buffer.
+		template<typename T, char_predicate Pred, typename Parse, typename CutShort>
+		auto parse_kept(const basic_filtered_string_view<Pred>& fsv, T& value, Parse parse, CutShort cut_short)
+		    -> from_chars_result {
+			if (keeps_everything(fsv.predicate())) {
+				auto const first = fsv.data();
+				auto const [ptr, ec] = parse(first, first + fsv.size(), value);
+				return {static_cast<std::size_t>(ptr - first), ec};
+			}
+			char buffer[128];
+			auto gathered = std::size_t{0};
+			auto const kept = fsv.scan();
+			auto it = kept.begin();
+			for (; it != kept.end() and number_chars(*it) and gathered != sizeof(buffer); ++it) {
+				buffer[gathered++] = *it;
+			}
+			// parsed into a copy, which a longer parse may yet replace, so that value is left alone on an error
+			auto parsed = value;
+			auto const [ptr, ec] = parse(buffer, buffer + gathered, parsed);
+			if (it == kept.end() or not number_chars(*it) or not cut_short(ptr, buffer + gathered)) {
+				if (ec == std::errc{}) {
+					value = parsed;
+				}
+				return {static_cast<std::size_t>(ptr - buffer), ec};
+			}
+			auto str = std::pmr::string(buffer, gathered);
+			for (; it != kept.end() and number_chars(*it); ++it) {
+				str.push_back(*it);
+			}
+			auto const [str_ptr, str_ec] = parse(str.data(), str.data() + str.size(), value);
+			return {static_cast<std::size_t>(str_ptr - str.data()), str_ec};
+		}
+	} // namespace detail
+
+	// parses an integer from the kept characters of fsv as std::from_chars does, without building a string:
+	// no leading whitespace or '+', and '-' only for signed types. value is left as it was on an error.
+	template<std::integral T, char_predicate Pred>
+	requires(not std::same_as<T, bool>)
+	auto from_chars(const basic_filtered_string_view<Pred>& fsv, T& value, int base = 10) -> from_chars_result {
+		return detail::parse_kept(
+		    fsv,
+		    value,
+		    [base](const char* first, const char* last, T& out) { return std::from_chars(first, last, out, base); },
+		    // the digits may go on past the buffer
+		    [](const char* stop, const char* last) { return stop == last; });
+	}
+
+	// parses a floating point number from the kept characters of fsv as std::from_chars does
+	template<std::floating_point T, char_predicate Pred>
+	auto from_chars(const basic_filtered_string_view<Pred>& fsv,
+	                T& value,
+	                std::chars_format fmt = std::chars_format::general) -> from_chars_result {
+		return detail::parse_kept(
+		    fsv,
+		    value,
+		    [fmt](const char* first, const char* last, T& out) { return std::from_chars(first, last, out, fmt); },
+		    // besides the digits going on, the parse backs off an exponent cut short ("1e", "1e+"), "inf" may be
+		    // the start of "infinity", and a nan's payload may close past the buffer
+		    [](const char* stop, const char* last) { return last - stop < 8 or *stop == '('; });
+	}
+
+	// an occurrence of one of the patterns of a multi_matcher among the kept characters of a view
+	template<char_predicate Pred>
+	struct pattern_match {
+		// the index of the pattern in the order the matcher was given them
+		std::size_t pattern;
+		// the position of the first matched character among the kept characters of the view
+		std::size_t pos;
+		// the offset of the first matched character in the underlying string, from the view's data()
+		std::size_t offset;
+		// the matched characters, with the view's predicate
+		basic_filtered_string_view<Pred> view;
+	};
+
+	// an Aho-Corasick automaton finding many patterns among the kept characters of a view in a single pass.
+	// the automaton is compiled into a dense transition table over the bytes the patterns use, one row per
+	// trie node, so that each kept character costs one lookup whatever the number of patterns. empty
+	// patterns match nothing.
+	class multi_matcher {
+	 public:
+		multi_matcher(std::initializer_list<std::string_view> patterns)
+		: multi_matcher{std::span{patterns.begin(), patterns.size()}} {}
+
+		template<std::ranges::input_range Patterns>
+		requires std::convertible_to<std::ranges::range_reference_t<Patterns>, std::string_view>
+		explicit multi_matcher(const Patterns& patterns) {
+			for (auto const& pattern : patterns) {
+				patterns_.emplace_back(std::string_view{pattern});
+			}
+			compile();
+		}
+
+		auto pattern_count() const noexcept -> std::size_t {
+			return patterns_.size();
+		}
+
+		auto pattern(std::size_t i) const -> std::string_view {
+			return patterns_.at(i);
+		}
+
+		// calls fn(match) with a pattern_match for every occurrence of every pattern in fsv, overlapping ones
+		// included, in the order they end; of those ending at the same character, longer patterns come first
+		template<char_predicate Pred, typename Fn>
+		auto for_each_match(const basic_filtered_string_view<Pred>& fsv, Fn fn) const -> void {
+			auto state = std::uint32_t{0};
+			auto pos = std::size_t{0};
+			fsv.for_each_run([&](const char* run, std::size_t count) {
+				for (auto i = std::size_t{0}; i < count; ++i) {
+					auto const uc = static_cast<unsigned char>(run[i]);
+					state = next_[(state >> 1) * classes_ + class_of_[uc]];
+					if ((state & 1) != 0) {
+						report(fsv, state >> 1, run, i, pos + i, fn);
+					}
+				}
+				pos += count;
+			});
+		}
 
-	auto split(const filtered_string_view& fsv, const filtered_string_view& tok) -> std::vector<filtered_string_view>;
+		// every match, as for_each_match() reports them
+		template<char_predicate Pred>
+		auto find_all(const basic_filtered_string_view<Pred>& fsv) const -> std::vector<pattern_match<Pred>> {
+			auto matches = std::vector<pattern_match<Pred>>{};
+			for_each_match(fsv, [&matches](pattern_match<Pred>&& match) { matches.push_back(std::move(match)); });
+			return matches;
+		}
+
+	 private:
+		std::vector<std::string> patterns_;
+		// the byte classes: 0 for bytes no pattern uses, and one for each byte some pattern does
+		std::array<std::uint16_t, 256> class_of_ = {};
+		std::size_t classes_ = 1;
+		// the transitions, classes_ per state: the next state shifted left by one, with the low bit set when
+		// some pattern ends there
+		std::vector<std::uint32_t> next_;
+		// the patterns ending at each state, longest first, at [output_begin_[s], output_begin_[s + 1])
+		std::vector<std::uint32_t> output_begin_;
+		std::vector<std::uint32_t> outputs_;
+
+		auto compile() -> void {
+			for (auto const& pattern : patterns_) {
+				for (auto const c : pattern) {
+					auto& cls = class_of_[static_cast<unsigned char>(c)];
+					if (cls == 0) {
+						cls = static_cast<std::uint16_t>(classes_++);
+					}
+				}
+			}
+			// the trie, with 0 for missing edges, which the root can stand for as it is nobody's child
+			auto own = std::vector<std::vector<std::uint32_t>>(1);
+			next_.assign(classes_, 0);
+			for (auto i = std::size_t{0}; i < patterns_.size(); ++i) {
+				if (patterns_[i].empty()) {
+					continue;
+				}
+				auto state = std::size_t{0};
+				for (auto const c : patterns_[i]) {
+					auto& edge = next_[state * classes_ + class_of_[static_cast<unsigned char>(c)]];
+					if (edge == 0) {
+						edge = static_cast<std::uint32_t>(own.size());
+						own.emplace_back();
+						next_.resize(next_.size() + classes_, 0);
+					}
+					state = next_[state * classes_ + class_of_[static_cast<unsigned char>(c)]];
+				}
+				own[state].push_back(static_cast<std::uint32_t>(i));
+			}
+			auto const states = own.size();
+			if (states > std::size_t{1} << 31) {
+				throw std::length_error{"multi_matcher: too many patterns"};
+			}
+
+			// breadth first, so that each state's failure state is complete before its own row: missing edges
+			// take the failure state's, and the outputs are the state's own followed by the failure state's
+			auto fail = std::vector<std::uint32_t>(states, 0);
+			auto order = std::vector<std::uint32_t>{0};
+			output_begin_.assign(states + 1, 0);
+			auto outputs = std::vector<std::vector<std::uint32_t>>(states);
+			for (auto head = std::size_t{0}; head < order.size(); ++head) {
+				auto const state = order[head];
+				auto* const row = next_.data() + state * classes_;
+				auto const* const fail_row = next_.data() + fail[state] * classes_;
+				for (auto cls = std::size_t{1}; cls < classes_; ++cls) {
+					if (row[cls] != 0) {
+						fail[row[cls]] = state == 0 ? 0 : fail_row[cls];
+						order.push_back(row[cls]);
+					}
+					else {
+						row[cls] = state == 0 ? 0 : fail_row[cls];
+					}
+				}
+				outputs[state] = std::move(own[state]);
+				if (state != 0) {
+					auto const& inherited = outputs[fail[state]];
+					outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+				}
+			}
+			for (auto state = std::size_t{0}; state < states; ++state) {
+				output_begin_[state] = static_cast<std::uint32_t>(outputs_.size());
+				outputs_.insert(outputs_.end(), outputs[state].begin(), outputs[state].end());
+			}
+			output_begin_[states] = static_cast<std::uint32_t>(outputs_.size());
+			for (auto& edge : next_) {
+				edge = edge << 1 | (outputs[edge].empty() ? 0 : 1);
+			}
+		}
+
+		// reports the patterns ending at state, whose last character is run[i], the end-th kept one
+		template<char_predicate Pred, typename Fn>
+		auto report(const basic_filtered_string_view<Pred>& fsv,
+		            std::uint32_t state,
+		            const char* run,
+		            std::size_t i,
+		            std::size_t end,
+		            Fn& fn) const -> void {
+			auto const last = run + i + 1;
+			for (auto k = output_begin_[state]; k != output_begin_[state + 1]; ++k) {
+				auto const pattern = outputs_[k];
+				auto const length = patterns_[pattern].size();
+				// the first character is in this run, or found by stepping back over the kept characters
+				auto first = last - std::min(length, i + 1);
+				for (auto left = length - std::min(length, i + 1); left != 0;) {
+					--first;
+					if (fsv.predicate_.get()(*first)) {
+						--left;
+					}
+				}
+				fn(pattern_match<Pred>{
+				    pattern,
+				    end + 1 - length,
+				    static_cast<std::size_t>(first - fsv.strptr_),
+				    basic_filtered_string_view<Pred>{first,
+				                                     static_cast<std::size_t>(last - first),
+				                                     fsv.predicate_,
+				                                     length}});
+			}
+		}
+	};
 
-	auto substr(const filtered_string_view& fsv, int pos = 0, int count = 0) -> filtered_string_view;
+	namespace detail {
+		// the first 8 kept characters of a view packed big-endian, zero padded, with how many there are up
+		// to 9, which is enough to order any two views which differ in them or have no more than 8
+		struct sort_key {
+			std::uint64_t prefix;
+			std::size_t index;
+			std::uint8_t size;
+		};
+
+		template<char_predicate Pred>
+		auto make_sort_key(const basic_filtered_string_view<Pred>& fsv, std::size_t index) -> sort_key {
+			auto key = sort_key{0, index, 0};
+			for (auto const c : fsv.scan()) {
+				if (key.size == 8) {
+					key.size = 9;
+					break;
+				}
+				key.prefix |= std::uint64_t{static_cast<unsigned char>(c)} << (56 - 8 * key.size);
+				++key.size;
+			}
+			return key;
+		}
+
+		// MSD radix sort of keys on the bytes of their prefixes from byte on, through buffer, which is as long.
+		// buckets too small to be worth counting and those past the prefix are left to std::sort with less.
+		template<typename Less>
+		auto radix_sort_keys(std::span<sort_key> keys, std::span<sort_key> buffer, int byte, const Less& less)
+		    -> void {
+			constexpr auto min_radix = std::size_t{64};
+			while (byte != 8 and keys.size() >= min_radix) {
+				auto const shift = 56 - 8 * byte;
+				auto counts = std::array<std::size_t, 257>{};
+				for (auto const& key : keys) {
+					++counts[(key.prefix >> shift & 0xff) + 1];
+				}
+				// keys which all share this byte go on to the next one without being moved
+				if (std::ranges::find(counts, keys.size()) != counts.end()) {
+					++byte;
+					continue;
+				}
+				std::partial_sum(counts.begin(), counts.end(), counts.begin());
+				auto next = counts;
+				for (auto const& key : keys) {
+					buffer[next[key.prefix >> shift & 0xff]++] = key;
+				}
+				std::ranges::copy(buffer.first(keys.size()), keys.begin());
+				for (auto bucket = std::size_t{0}; bucket < 256; ++bucket) {
+					auto const size = counts[bucket + 1] - counts[bucket];
+					if (size > 1) {
+						radix_sort_keys(keys.subspan(counts[bucket], size), buffer, byte + 1, less);
+					}
+				}
+				return;
+			}
+			std::sort(keys.begin(), keys.end(), less);
+		}
+	} // namespace detail
+
+	// sorts views into the order of operator<=>, like std::ranges::sort(views) but without calling the
+	// predicates on every comparison: the first kept characters of each view are packed into a key once,
+	// the keys are radix sorted, and only views whose keys tie are compared in full. equal views may end up
+	// in any order, as with std::sort.
+	template<std::ranges::random_access_range Views>
+	requires detail::is_filtered_view<std::ranges::range_value_t<Views>>
+	         and std::permutable<std::ranges::iterator_t<Views>>
+	auto sort(Views&& views) -> void {
+		auto const count = static_cast<std::size_t>(std::ranges::distance(views));
+		auto const first = std::ranges::begin(views);
+		auto keys = std::vector<detail::sort_key>{};
+		keys.reserve(count);
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			keys.push_back(detail::make_sort_key(first[static_cast<std::ptrdiff_t>(i)], i));
+		}
+		auto const less = [first](const detail::sort_key& lhs, const detail::sort_key& rhs) {
+			if (lhs.prefix != rhs.prefix or lhs.size != rhs.size or lhs.size <= 8) {
+				return std::tie(lhs.prefix, lhs.size) < std::tie(rhs.prefix, rhs.size);
+			}
+			return first[static_cast<std::ptrdiff_t>(lhs.index)] < first[static_cast<std::ptrdiff_t>(rhs.index)];
+		};
+		auto buffer = std::vector<detail::sort_key>(count);
+		detail::radix_sort_keys(keys, buffer, 0, less);
+
+		auto sorted = std::vector<std::ranges::range_value_t<Views>>{};
+		sorted.reserve(count);
+		for (auto const& key : keys) {
+			sorted.push_back(std::ranges::iter_move(first + static_cast<std::ptrdiff_t>(key.index)));
+		}
+		std::ranges::move(sorted, first);
+	}
+
+	// a view over the same characters as a filtered view, with the offset of every kept character computed
+	// up front (one word per kept character) and shared between copies. its iterator is random access: it + n,
+	// it[n] and it2 - it1 are O(1), so std::ranges algorithms such as lower_bound or distance take their
+	// random access paths. unlike with_index(), the table is built eagerly and trades memory for speed.
+	template<char_predicate Pred>
+	class basic_indexed_view : public std::ranges::view_interface<basic_indexed_view<Pred>> {
+		class iter {
+		 public:
+			using iterator_concept = std::random_access_iterator_tag;
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = char;
+			using reference = const char&;
+			using pointer = const char*;
+			using difference_type = std::ptrdiff_t;
 
+			iter() noexcept = default;
+
+			auto operator*() const -> reference {
+				return base_[*offset_];
+			}
+
+			auto operator[](difference_type n) const -> reference {
+				return base_[offset_[n]];
+			}
+
+			auto operator++() -> iter& {
+				++offset_;
+				return *this;
+			}
+
+			auto operator++(int) -> iter {
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			auto operator--() -> iter& {
+				--offset_;
+				return *this;
+			}
+
+			auto operator--(int) -> iter {
+				auto copy = *this;
+				--*this;
+				return copy;
+			}
+
+			auto operator+=(difference_type n) -> iter& {
+				offset_ += n;
+				return *this;
+			}
+
+			auto operator-=(difference_type n) -> iter& {
+				offset_ -= n;
+				return *this;
+			}
+
+			friend auto operator+(iter it, difference_type n) -> iter {
+				return it += n;
+			}
+
+			friend auto operator+(difference_type n, iter it) -> iter {
+				return it += n;
+			}
+
+			friend auto operator-(iter it, difference_type n) -> iter {
+				return it -= n;
+			}
+
+			friend auto operator-(const iter& lhs, const iter& rhs) -> difference_type {
+				return lhs.offset_ - rhs.offset_;
+			}
+
+			friend auto operator==(const iter& lhs, const iter& rhs) noexcept -> bool {
+				return lhs.offset_ == rhs.offset_;
+			}
+
+			friend auto operator<=>(const iter& lhs, const iter& rhs) noexcept -> std::strong_ordering {
+				return lhs.offset_ <=> rhs.offset_;
+			}
+
+		 private:
+			iter(const char* base, const std::size_t* offset)
+			: base_{base}
+			, offset_{offset} {}
+
+			const char* base_ = nullptr;
+			const std::size_t* offset_ = nullptr;
+
+			friend class basic_indexed_view;
+		};
+
+	 public:
+		using iterator = iter;
+		using const_iterator = iterator;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = reverse_iterator;
+
+		explicit basic_indexed_view(basic_filtered_string_view<Pred> fsv)
+		: fsv_{std::move(fsv)}
+		, offsets_{std::make_shared<const std::vector<std::size_t>>(kept_offsets(fsv_))} {}
+
+		auto begin() const noexcept -> const_iterator {
+			return iterator{fsv_.strptr_, offsets_->data()};
+		}
+
+		auto end() const noexcept -> const_iterator {
+			return iterator{fsv_.strptr_, offsets_->data() + offsets_->size()};
+		}
+
+		auto rbegin() const noexcept -> const_reverse_iterator {
+			return const_reverse_iterator{end()};
+		}
+
+		auto rend() const noexcept -> const_reverse_iterator {
+			return const_reverse_iterator{begin()};
+		}
+
+		auto size() const noexcept -> std::size_t {
+			return offsets_->size();
+		}
+
+		// the offset in the underlying data of the n-th kept character
+		auto offset(std::size_t n) const -> std::size_t {
+			return (*offsets_)[n];
+		}
+
+		auto view() const noexcept -> const basic_filtered_string_view<Pred>& {
+			return fsv_;
+		}
+
+	 private:
+		static auto kept_offsets(const basic_filtered_string_view<Pred>& fsv) -> std::vector<std::size_t> {
+			auto offsets = std::vector<std::size_t>{};
+			offsets.reserve(fsv.size());
+			auto const& predicate = fsv.predicate();
+			for (auto i = std::size_t{0}; i < fsv.length_; ++i) {
+				if (predicate(fsv.strptr_[i])) {
+					offsets.push_back(i);
+				}
+			}
+			return offsets;
+		}
+
+		basic_filtered_string_view<Pred> fsv_;
+		std::shared_ptr<const std::vector<std::size_t>> offsets_;
+	};
+
+	using indexed_view = basic_indexed_view<filter>;
+
+
+	// hashes the kept characters of a view with XXH64 in a single pass, without building a string.
+	// std::string and std::string_view hash like a view of the same characters, so together with
+	// equal_to, unordered containers keyed by strings can be searched with views and the other way round.
+	struct hash {
+		using is_transparent = void;
+
+		auto operator()(std::string_view str) const noexcept -> std::size_t {
+			auto hasher = detail::xxh64{};
+			hasher.update(str.data(), str.size());
+			return static_cast<std::size_t>(hasher.digest());
+		}
+
+		template<char_predicate Pred>
+		auto operator()(const basic_filtered_string_view<Pred>& fsv) const -> std::size_t {
+			auto hasher = detail::xxh64{};
+			fsv.for_each_block([&hasher](const char* kept, std::size_t count) { hasher.update(kept, count); });
+			return static_cast<std::size_t>(hasher.digest());
+		}
+	};
+
+	// compares the kept characters of views, and of views against strings, without building strings
+	struct equal_to {
+		using is_transparent = void;
+
+		template<char_predicate LPred, char_predicate RPred>
+		auto operator()(const basic_filtered_string_view<LPred>& lhs, const basic_filtered_string_view<RPred>& rhs) const
+		    -> bool {
+			if constexpr (std::same_as<LPred, RPred>) {
+				return lhs == rhs;
+			}
+			else {
+				return detail::compare_kept(lhs.strptr_,
+				                            lhs.length_,
+				                            lhs.predicate_.get(),
+				                            rhs.strptr_,
+				                            rhs.length_,
+				                            rhs.predicate_.get())
+				       == 0;
+			}
+		}
+
+		template<char_predicate Pred>
+		auto operator()(const basic_filtered_string_view<Pred>& lhs, std::string_view rhs) const -> bool {
+			return detail::compare_kept(lhs.strptr_, lhs.length_, lhs.predicate_.get(), rhs.data(), rhs.size(), true_predicate{})
+			       == 0;
+		}
+
+		template<char_predicate Pred>
+		auto operator()(std::string_view lhs, const basic_filtered_string_view<Pred>& rhs) const -> bool {
+			return (*this)(rhs, lhs);
+		}
+
+		auto operator()(std::string_view lhs, std::string_view rhs) const noexcept -> bool {
+			return lhs == rhs;
+		}
+	};
 } // namespace fsv
 
+template<fsv::char_predicate Pred>
+struct std::hash<fsv::basic_filtered_string_view<Pred>> {
+	auto operator()(const fsv::basic_filtered_string_view<Pred>& fsv) const -> std::size_t {
+		return fsv::hash{}(fsv);
+	}
+};
+
 #endif // COMP6771_ASS2_FSV_H
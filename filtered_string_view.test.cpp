@@ -1,10 +1,18 @@
 #include "./filtered_string_view.h"
 
+#include <atomic>
 #include <catch2/catch.hpp>
+#include <cctype>
+#include <cmath>
+#include <forward_list>
+#include <iomanip>
 #include <iostream>
+#include <memory_resource>
 #include <regex>
 #include <set>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 TEST_CASE("fsv default constructor") {
 	auto const fsv1 = fsv::filtered_string_view{};
@@ -35,6 +43,15 @@ TEST_CASE("fsv string constructor with predicate") {
 	auto const size = fsv1.size();
 	CHECK(size == 1);
 	CHECK(fsv1.data() == s);
+
+	// only predicates stored inline are taken without allocating
+	static_assert(not std::is_nothrow_constructible_v<fsv::filtered_string_view, const std::string&, fsv::filter>);
+	static_assert(std::is_nothrow_constructible_v<fsv::basic_filtered_string_view<fsv::char_class>,
+	                                              const std::string&,
+	                                              fsv::char_class>);
+	static_assert(std::is_nothrow_constructible_v<fsv::basic_filtered_string_view<decltype(pred)>,
+	                                              const std::string&,
+	                                              decltype(pred)>);
 }
 
 TEST_CASE("fsv implicit null-terminated string constructor") {
@@ -144,6 +161,17 @@ TEST_CASE("string type conversion") {
 		auto const fsv = fsv::filtered_string_view{"bob", predicate};
 		CHECK(static_cast<std::string>(fsv) == "bb");
 	}
+	SECTION("a view keeping everything is copied whole, NULs included") {
+		auto const str = std::string{"a\0b\0c", 5};
+		CHECK(static_cast<std::string>(fsv::filtered_string_view{str}) == str);
+		CHECK(static_cast<std::string>(fsv::filtered_string_view{str, fsv::true_predicate{}}) == str);
+		CHECK(static_cast<std::string>(fsv::basic_filtered_string_view{str, fsv::true_predicate{}}) == str);
+	}
+	SECTION("a view whose size is known") {
+		auto const fsv = fsv::filtered_string_view{"b.o.b", [](const char& c) { return c != '.'; }};
+		REQUIRE(fsv.size() == 3);
+		CHECK(static_cast<std::string>(fsv) == "bob");
+	}
 }
 
 TEST_CASE("at") {
@@ -352,6 +380,45 @@ TEST_CASE("output stream") {
 		std::cout.rdbuf(oldCoutBuffer);
 		CHECK(buffer.str() == "");
 	}
+	SECTION("the same whatever the type of the predicate") {
+		auto const str = std::string{"a1 b2 c3"};
+		auto const letters = [](const char& c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; };
+		auto const print = [](const auto& view) {
+			auto os = std::ostringstream{};
+			os << '[' << view << ']' << 1;
+			return os.str();
+		};
+		CHECK(print(fsv::basic_filtered_string_view{str, fsv::char_class::alpha()}) == "[abc]1");
+		CHECK(print(fsv::filtered_string_view{str, fsv::char_class::alpha()}) == "[abc]1");
+		CHECK(print(fsv::basic_filtered_string_view{str, letters}) == "[abc]1");
+		CHECK(print(fsv::filtered_string_view{str, letters}) == "[abc]1");
+		CHECK(print(fsv::filtered_string_view{str, letters}.with_runs()) == "[abc]1");
+	}
+	SECTION("padded to the width, like a std::string_view") {
+		auto const sv = fsv::filtered_string_view{"a.b", [](const char& c) { return c != '.'; }};
+		auto const print = [](const auto& view, auto... manips) {
+			auto os = std::ostringstream{};
+			(os << ... << manips) << view << '|' << 42;
+			return os.str();
+		};
+		CHECK(print(sv, std::setw(6)) == "    ab|42");
+		CHECK(print(sv, std::setw(6)) == print(std::string_view{"ab"}, std::setw(6)));
+		CHECK(print(sv, std::setw(6), std::left, std::setfill('*')) == "ab****|42");
+		CHECK(print(fsv::basic_filtered_string_view{"a1b2", fsv::char_class::alpha()}, std::setw(4), std::right)
+		      == "  ab|42");
+		CHECK(print(sv, std::setw(1)) == "ab|42");
+		// write_to is unformatted, and leaves the width alone
+		auto os = std::ostringstream{};
+		os << std::setw(4);
+		fsv::write_to(os, sv) << 'c';
+		CHECK(os.str() == "ab   c");
+	}
+	SECTION("nothing is written to a failed stream") {
+		auto os = std::ostringstream{};
+		os.setstate(std::ios_base::failbit);
+		os << fsv::basic_filtered_string_view{"abc", fsv::char_class::alpha()} << fsv::filtered_string_view{"abc"};
+		CHECK(os.str().empty());
+	}
 }
 
 TEST_CASE("compose") {
@@ -679,4 +746,1165 @@ TEST_CASE("basic iter operations") {
 		iter2++;
 		CHECK(*iter1 == *iter2);
 	}
-}
\ No newline at end of file
+}
+TEST_CASE("basic_filtered_string_view with a statically typed predicate") {
+	auto const is_digit = [](const char& c) { return c >= '0' and c <= '9'; };
+	SECTION("the predicate type is deduced from the constructor") {
+		auto const sv = fsv::basic_filtered_string_view{"a1b2c3", is_digit};
+		STATIC_REQUIRE(std::is_same_v<decltype(sv)::predicate_type, std::remove_const_t<decltype(is_digit)>>);
+		CHECK(sv.size() == 3);
+		CHECK(static_cast<std::string>(sv) == "123");
+		CHECK(sv[1] == '2');
+		CHECK(std::string(sv.rbegin(), sv.rend()) == "321");
+	}
+	SECTION("the default predicate keeps every character") {
+		auto const sv = fsv::basic_filtered_string_view<fsv::true_predicate>{"Samoyed"};
+		CHECK(sv.size() == 7);
+		CHECK(static_cast<std::string>(fsv::substr(sv, 3)) == "oyed");
+	}
+	SECTION("copy assignment works with lambdas, which are not assignable themselves") {
+		auto sv1 = fsv::basic_filtered_string_view{"x9y8", is_digit};
+		auto const sv2 = fsv::basic_filtered_string_view{"7z", is_digit};
+		sv1 = sv2;
+		CHECK(sv1 == sv2);
+		CHECK(sv1.data() == sv2.data());
+	}
+	SECTION("converts to the type-erased filtered_string_view") {
+		auto const sv = fsv::basic_filtered_string_view{"4 paws", is_digit};
+		auto const erased = fsv::filtered_string_view{sv};
+		CHECK(erased.data() == sv.data());
+		CHECK(erased == fsv::filtered_string_view{"4"});
+	}
+	SECTION("split keeps the statically typed predicate") {
+		auto const sv = fsv::basic_filtered_string_view{"1a0b0c1", [](const char& c) { return c != 'a' and c != 'c'; }};
+		auto const v = fsv::split(sv, fsv::filtered_string_view{"0"});
+		REQUIRE(v.size() == 3);
+		CHECK(static_cast<std::string>(v[0]) == "1");
+		CHECK(static_cast<std::string>(v[1]) == "b");
+		CHECK(static_cast<std::string>(v[2]) == "1");
+	}
+}
+
+TEST_CASE("with_index") {
+	auto const pred = [](const char& c) { return c != '-'; };
+	auto str = std::string{};
+	auto expected = std::string{};
+	for (auto i = 0; i < 2000; ++i) {
+		auto const c = static_cast<char>('a' + i % 26);
+		str += (i % 3 == 0) ? '-' : c;
+		if (i % 3 != 0) {
+			expected += c;
+		}
+	}
+	auto const plain = fsv::filtered_string_view{str, pred};
+	auto const indexed = plain.with_index();
+	CHECK_FALSE(plain.has_index());
+	CHECK(indexed.has_index());
+
+	SECTION("gives the same answers as the unindexed view") {
+		REQUIRE(indexed.size() == expected.size());
+		auto via_subscript = std::string{};
+		for (auto i = 0; i < static_cast<int>(indexed.size()); ++i) {
+			via_subscript += indexed[i];
+		}
+		CHECK(via_subscript == expected);
+		CHECK(&indexed.at(700) == &plain.at(700));
+		CHECK(static_cast<std::string>(fsv::substr(indexed, 600, 50)) == expected.substr(600, 50));
+		CHECK(static_cast<std::string>(fsv::substr(indexed, 1300)) == expected.substr(1300));
+	}
+	SECTION("still throws on invalid indices") {
+		CHECK_THROWS_AS(indexed.at(-1), std::domain_error);
+		CHECK_THROWS_WITH(indexed.at(static_cast<int>(expected.size())),
+		                  "filtered_string_view::at(" + std::to_string(expected.size()) + "): invalid index");
+	}
+	SECTION("copies share the index") {
+		auto const copy = indexed;
+		CHECK(copy.has_index());
+		CHECK(copy.size() == expected.size());
+		CHECK(copy.at(5) == expected[5]);
+	}
+	SECTION("on an empty view") {
+		auto const empty = fsv::filtered_string_view{}.with_index();
+		CHECK(empty.size() == 0);
+		CHECK_THROWS_AS(empty.at(0), std::domain_error);
+	}
+}
+
+TEST_CASE("size is memoized") {
+	auto calls = 0;
+	auto const counting_pred = [&calls](const char& c) {
+		++calls;
+		return c != ' ';
+	};
+	auto const sv = fsv::filtered_string_view{"Bernese Mountain Dog", counting_pred};
+	SECTION("repeated calls run the predicate over the string once") {
+		CHECK(sv.size() == 18);
+		CHECK(calls == 20);
+		CHECK(sv.size() == 18);
+		CHECK_FALSE(sv.empty());
+		CHECK(calls == 20);
+	}
+	SECTION("copies keep the computed size") {
+		CHECK(sv.size() == 18);
+		auto const copy = sv;
+		auto moved = fsv::filtered_string_view{};
+		moved = fsv::filtered_string_view{copy};
+		calls = 0;
+		CHECK(copy.size() == 18);
+		CHECK(moved.size() == 18);
+		CHECK(calls == 0);
+	}
+	SECTION("substr and split know the size of their results") {
+		auto const sub = fsv::substr(sv, 7, 8);
+		auto const pieces = fsv::split(sv, fsv::filtered_string_view{"n"});
+		calls = 0;
+		CHECK(sub.size() == 8);
+		REQUIRE(pieces.size() == 4);
+		CHECK(pieces[0].size() == 3);
+		CHECK(pieces[1].size() == 6);
+		CHECK(pieces[2].size() == 3);
+		CHECK(pieces[3].size() == 3);
+		CHECK(calls == 0);
+		CHECK(static_cast<std::string>(pieces[1]) == "eseMou");
+	}
+}
+
+TEST_CASE("char_class") {
+	SECTION("membership") {
+		auto const hex = fsv::char_class::hex_digits();
+		CHECK(hex('a'));
+		CHECK(hex('F'));
+		CHECK(hex('0'));
+		CHECK_FALSE(hex('g'));
+		CHECK_FALSE(hex('\xff'));
+		CHECK(hex.count() == 22);
+		CHECK((~hex).count() == 256 - 22);
+		CHECK((hex & fsv::char_class::digits()) == fsv::char_class::digits());
+		CHECK((fsv::char_class::lower() | fsv::char_class::upper()) == fsv::char_class::alpha());
+		auto const interest = std::set<char>{'a', 'b', 'c', ' ', '/'};
+		CHECK(fsv::char_class{interest.begin(), interest.end()} == fsv::char_class{"cba /"});
+		CHECK(fsv::char_class::from([](const char& c) { return c == '\x80' or c == 'z'; }) == fsv::char_class{"\x80z"});
+	}
+
+	// long enough to go through the vectorised kernels, with every byte value present
+	auto str = std::string{};
+	for (auto i = 0; i < 5000; ++i) {
+		str += static_cast<char>((i * 7919 + i / 3) % 256);
+	}
+	auto const cls = fsv::char_class::alnum() | fsv::char_class{"\x80\xfe\x01"};
+	auto const as_lambda = [cls](const char& c) { return cls.contains(c); };
+	auto expected = std::string{};
+	std::copy_if(str.begin(), str.end(), std::back_inserter(expected), as_lambda);
+
+	SECTION("a statically typed view with a char_class") {
+		auto const sv = fsv::basic_filtered_string_view{str, cls};
+		CHECK(sv.size() == expected.size());
+		CHECK(static_cast<std::string>(sv) == expected);
+		auto out = std::ostringstream{};
+		out << sv;
+		CHECK(out.str() == expected);
+	}
+	SECTION("a char_class behind a filter") {
+		auto const sv = fsv::filtered_string_view{str, cls};
+		CHECK(sv.size() == expected.size());
+		CHECK(static_cast<std::string>(sv) == expected);
+		auto out = std::ostringstream{};
+		out << sv;
+		CHECK(out.str() == expected);
+		CHECK(sv == fsv::filtered_string_view{str, as_lambda});
+	}
+	SECTION("a short view") {
+		auto const sv = fsv::filtered_string_view{"0xDEADBEEF / 0xdeadbeef", fsv::char_class::hex_digits()};
+		CHECK(static_cast<std::string>(sv) == "0DEADBEEF0deadbeef");
+		CHECK(sv.size() == 18);
+	}
+}
+
+TEST_CASE("compose fuses predicates") {
+	auto const sv = fsv::filtered_string_view{"0x1F 0xab 0xZZ"};
+	SECTION("adjacent char_classes become one table") {
+		auto const vf = std::vector<fsv::filter>{fsv::char_class::hex_digits(), fsv::char_class::alpha()};
+		auto const composed = fsv::compose(sv, vf);
+		auto const* cls = composed.predicate().target<fsv::char_class>();
+		REQUIRE(cls != nullptr);
+		CHECK(*cls == fsv::char_class{"abcdefABCDEF"});
+		CHECK(static_cast<std::string>(composed) == "Fab");
+	}
+	SECTION("composed predicates are flattened instead of nested") {
+		auto const inner = fsv::compose(sv, {fsv::char_class::alnum(), [](const char& c) { return c != 'x'; }});
+		auto const outer = fsv::compose(sv, {inner.predicate(), fsv::char_class::hex_digits()});
+		CHECK(static_cast<std::string>(outer) == "01F0ab0");
+		auto const* chain = outer.predicate().target<fsv::detail::filter_chain>();
+		REQUIRE(chain != nullptr);
+		// alnum, the lambda and hex digits; the lambda keeps the two tables apart
+		CHECK(chain->filters.size() == 3);
+	}
+	SECTION("true predicates are dropped") {
+		auto const composed = fsv::compose(sv, {fsv::true_predicate{}, fsv::char_class::digits()});
+		CHECK(composed.predicate().target<fsv::char_class>() != nullptr);
+		CHECK(static_cast<std::string>(composed) == "0100");
+	}
+	SECTION("statically typed predicates") {
+		auto const is_not_x = [](const char& c) { return c != 'x'; };
+		auto const composed = fsv::compose(sv, fsv::char_class::alnum(), is_not_x);
+		STATIC_REQUIRE(std::is_same_v<decltype(composed)::predicate_type,
+		                              fsv::conjunction<fsv::char_class, std::remove_const_t<decltype(is_not_x)>>>);
+		CHECK(static_cast<std::string>(composed) == "01F0ab0ZZ");
+
+		auto const tables = fsv::compose(sv, fsv::char_class::alnum(), fsv::char_class::upper());
+		STATIC_REQUIRE(std::is_same_v<decltype(tables)::predicate_type, fsv::char_class>);
+		CHECK(static_cast<std::string>(tables) == "FZZ");
+	}
+}
+
+TEST_CASE("split_view") {
+	auto const sv = fsv::filtered_string_view{"a,b,,c!", [](const char& c) { return c != '!'; }};
+	auto const tok = fsv::filtered_string_view{","};
+	STATIC_REQUIRE(std::ranges::forward_range<fsv::split_view<fsv::filter>>);
+	STATIC_REQUIRE(std::ranges::view<fsv::split_view<fsv::filter>>);
+
+	SECTION("gives the same pieces as split") {
+		auto pieces = std::vector<std::string>{};
+		for (auto const& piece : fsv::split_view{sv, tok}) {
+			pieces.push_back(static_cast<std::string>(piece));
+		}
+		CHECK(pieces == std::vector<std::string>{"a", "b", "", "c"});
+		CHECK(std::ranges::equal(fsv::split_view{sv, tok}, fsv::split(sv, tok)));
+		CHECK(std::ranges::distance(fsv::split_view{sv, fsv::filtered_string_view{"x"}}) == 1);
+		CHECK(std::ranges::distance(fsv::split_view{fsv::filtered_string_view{}, tok}) == 1);
+	}
+	SECTION("works with the existing split test cases") {
+		auto const xx = fsv::filtered_string_view{"xx"};
+		auto const x = fsv::filtered_string_view{"x"};
+		CHECK(std::ranges::equal(fsv::split_view{xx, x}, std::vector<fsv::filtered_string_view>{"", "", ""}));
+		auto const blah = fsv::filtered_string_view{"blahblah", [](const char& c) { return c == 'b' or c == 'l' or c == 'h'; }};
+		auto const light = fsv::filtered_string_view{"my light", [](const char& c) { return c == 'l'; }};
+		CHECK(std::ranges::equal(fsv::split_view{blah, light}, std::vector<fsv::filtered_string_view>{"b", "hb", "h"}));
+	}
+	SECTION("into a caller supplied buffer") {
+		auto buffer = std::array<fsv::filtered_string_view, 3>{};
+		auto const count = fsv::split(sv, tok, buffer);
+		CHECK(count == 4);
+		CHECK(buffer[0] == fsv::filtered_string_view{"a"});
+		CHECK(buffer[1] == fsv::filtered_string_view{"b"});
+		CHECK(buffer[2].empty());
+		CHECK(fsv::split(sv, tok, {}) == 4);
+	}
+}
+
+TEST_CASE("find and friends") {
+	auto const sv = fsv::filtered_string_view{"ab-ra-ca-dab-ra", [](const char& c) { return c != '-'; }};
+	SECTION("find") {
+		CHECK(sv.find("abra") == 0);
+		CHECK(sv.find("abra", 1) == 7);
+		CHECK(sv.find("cad") == 4);
+		CHECK(sv.find("a", 8) == 10);
+		CHECK(sv.find("abrab") == fsv::filtered_string_view::npos);
+		CHECK(sv.find("ra-ca") == fsv::filtered_string_view::npos);
+		CHECK(sv.find("") == 0);
+		CHECK(sv.find("", 11) == 11);
+		CHECK(sv.find("", 12) == fsv::filtered_string_view::npos);
+		CHECK(sv.find(fsv::filtered_string_view{"r.a", [](const char& c) { return c != '.'; }}) == 2);
+	}
+	SECTION("rfind") {
+		CHECK(sv.rfind("abra") == 7);
+		CHECK(sv.rfind("abra", 6) == 0);
+		CHECK(sv.rfind("a") == 10);
+		CHECK(sv.rfind("a", 9) == 7);
+		CHECK(sv.rfind("x") == fsv::filtered_string_view::npos);
+		CHECK(sv.rfind("abracadabraa") == fsv::filtered_string_view::npos);
+		CHECK(sv.rfind("") == 11);
+		CHECK(sv.rfind("", 3) == 3);
+	}
+	SECTION("contains, starts_with and ends_with") {
+		CHECK(sv.contains("racad"));
+		CHECK_FALSE(sv.contains("rr"));
+		CHECK(sv.starts_with("abr"));
+		CHECK(sv.starts_with(""));
+		CHECK_FALSE(sv.starts_with("abracadabra!"));
+		CHECK(sv.ends_with("dabra"));
+		CHECK(sv.ends_with(fsv::filtered_string_view{"bra"}));
+		CHECK_FALSE(sv.ends_with("cabra"));
+		CHECK_FALSE(fsv::filtered_string_view{}.ends_with("a"));
+	}
+	SECTION("agrees with std::string on longer inputs") {
+		auto str = std::string{};
+		for (auto i = 0; i < 3000; ++i) {
+			str += "ab.c"[(i * i + i / 7) % 4];
+		}
+		auto const no_dots = [](const char& c) { return c != '.'; };
+		auto filtered = std::string{};
+		std::copy_if(str.begin(), str.end(), std::back_inserter(filtered), no_dots);
+		auto const filtered_sv = fsv::filtered_string_view{str, no_dots};
+		auto const plain_sv = fsv::filtered_string_view{str};
+		for (auto const* needle : {"a", "abca", "cabba", "bbbb", "cbcbcb", "acbacb", "aaaaaaaaaaaaaaaaa"}) {
+			for (auto pos : {std::size_t{0}, std::size_t{100}, std::size_t{2000}}) {
+				CHECK(filtered_sv.find(needle, pos) == filtered.find(needle, pos));
+				CHECK(filtered_sv.rfind(needle, pos) == filtered.rfind(needle, pos));
+				CHECK(plain_sv.find(needle, pos) == str.find(needle, pos));
+				CHECK(plain_sv.rfind(needle, pos) == str.rfind(needle, pos));
+			}
+		}
+	}
+}
+
+TEST_CASE("copies share the predicate") {
+	// counts how many times it is copied, and carries enough state not to be stored inline
+	struct copy_counting_pred {
+		int* copies;
+		std::set<char> keep;
+
+		copy_counting_pred(int* copies, std::set<char> keep)
+		: copies{copies}
+		, keep{std::move(keep)} {}
+
+		copy_counting_pred(const copy_counting_pred& other)
+		: copies{other.copies}
+		, keep{other.keep} {
+			++*copies;
+		}
+
+		auto operator()(const char& c) const -> bool {
+			return keep.contains(c);
+		}
+	};
+
+	auto copies = 0;
+	auto const sv = fsv::basic_filtered_string_view{"a-b-c-d", copy_counting_pred{&copies, {'a', 'b', 'c', 'd', '-'}}};
+	copies = 0;
+
+	auto const copy = sv;
+	auto moved = fsv::basic_filtered_string_view{std::move(fsv::basic_filtered_string_view{sv})};
+	moved = copy;
+	auto const sub = fsv::substr(sv, 2, 3);
+	auto const pieces = fsv::split(sv, fsv::filtered_string_view{"-"});
+	auto const it = std::next(sv.begin(), 2);
+	CHECK(copies == 0);
+
+	CHECK(&copy.predicate() == &sv.predicate());
+	CHECK(&sub.predicate() == &sv.predicate());
+	CHECK(&pieces[3].predicate() == &sv.predicate());
+	CHECK(static_cast<std::string>(sub) == "b-c");
+	CHECK(*it == 'b');
+	CHECK(pieces.size() == 4);
+}
+
+TEST_CASE("iterators are small and trivially copyable") {
+	auto const is_vowel = [](const char& c) { return std::string_view{"aeiou"}.find(c) != std::string_view::npos; };
+	using typed_view = fsv::basic_filtered_string_view<std::remove_const_t<decltype(is_vowel)>>;
+	STATIC_REQUIRE(std::is_trivially_copyable_v<fsv::filtered_string_view::iterator>);
+	STATIC_REQUIRE(sizeof(fsv::filtered_string_view::iterator) == 2 * sizeof(void*));
+	STATIC_REQUIRE(std::bidirectional_iterator<fsv::filtered_string_view::iterator>);
+	STATIC_REQUIRE(std::bidirectional_iterator<typed_view::iterator>);
+	STATIC_REQUIRE(std::is_trivially_copyable_v<typed_view::scan_iterator>);
+	STATIC_REQUIRE(std::forward_iterator<typed_view::scan_iterator>);
+	STATIC_REQUIRE(std::sentinel_for<std::default_sentinel_t, typed_view::scan_iterator>);
+
+	SECTION("scan") {
+		auto const sv = typed_view{"Weimaraner", is_vowel};
+		auto kept = std::string{};
+		for (auto const c : sv.scan()) {
+			kept += c;
+		}
+		CHECK(kept == "eiaae");
+		CHECK(std::ranges::distance(sv.scan()) == 5);
+		CHECK(std::ranges::equal(sv.scan(), sv));
+		CHECK(fsv::filtered_string_view{}.scan().empty());
+		CHECK(fsv::filtered_string_view{"xyz", is_vowel}.scan().empty());
+	}
+	SECTION("default constructed iterators compare equal") {
+		CHECK(typed_view::iterator{} == typed_view::iterator{});
+	}
+}
+
+TEST_CASE("indexed_view") {
+	auto const sv = fsv::filtered_string_view{"a-b-b-c-d-d-d-f", [](const char& c) { return c != '-'; }};
+	auto const iv = fsv::indexed_view{sv};
+	STATIC_REQUIRE(std::random_access_iterator<fsv::indexed_view::iterator>);
+	STATIC_REQUIRE(std::ranges::random_access_range<fsv::indexed_view>);
+	STATIC_REQUIRE(std::ranges::sized_range<fsv::indexed_view>);
+	STATIC_REQUIRE(std::ranges::view<fsv::indexed_view>);
+
+	CHECK(iv.size() == 8);
+	CHECK(std::ranges::equal(iv, sv));
+	CHECK(iv[3] == 'c');
+	CHECK(*(iv.begin() + 7) == 'f');
+	CHECK(iv.end() - iv.begin() == 8);
+	CHECK(iv.begin()[5] == 'd');
+	CHECK(iv.offset(3) == 6);
+	CHECK(&iv[3] == sv.data() + 6);
+	CHECK(std::string(iv.rbegin(), iv.rend()) == "fdddcbba");
+
+	// the filtered string is sorted, so it can be binary searched
+	auto const [first, last] = std::ranges::equal_range(iv, 'd');
+	CHECK(first - iv.begin() == 4);
+	CHECK(last - first == 3);
+	CHECK(std::ranges::binary_search(iv, 'c'));
+	CHECK_FALSE(std::ranges::binary_search(iv, 'e'));
+
+	SECTION("on an empty view") {
+		auto const empty = fsv::indexed_view{fsv::filtered_string_view{}};
+		CHECK(empty.empty());
+		CHECK(empty.begin() == empty.end());
+	}
+}
+
+namespace {
+	// built at compile time, so no static initialisation order issues
+	constinit auto const literal_digits =
+	    fsv::basic_filtered_string_view{std::string_view{"a1b2c3"}, fsv::char_class::digits()};
+	constinit auto const literal_frame = fsv::basic_filtered_string_view<fsv::true_predicate>{"ab\0cd", 5};
+} // namespace
+
+TEST_CASE("pointer and length constructors") {
+	auto const frame = std::string{"len\0\x03" "abc", 8};
+
+	SECTION("a length keeps embedded NULs") {
+		auto const sv = fsv::filtered_string_view{frame.data(), frame.size()};
+		CHECK(sv.size() == 8);
+		CHECK(static_cast<std::string>(sv) == frame);
+	}
+
+	SECTION("from a string_view") {
+		auto const sv = fsv::filtered_string_view{std::string_view{frame}, [](const char& c) { return c != '\0'; }};
+		CHECK(sv.size() == 7);
+		CHECK(sv.data() == frame.data());
+	}
+
+	SECTION("constinit views over literals") {
+		CHECK(static_cast<std::string>(literal_digits) == "123");
+		CHECK(literal_frame.size() == 5);
+		CHECK(literal_frame[2] == '\0');
+	}
+}
+
+TEST_CASE("parallel size and to_string") {
+	auto str = std::string{};
+	for (auto i = 0; i < 5000; ++i) {
+		str += "row " + std::to_string(i) + ", ";
+	}
+	// a small grain so that the chunks are split even on small inputs
+	auto const policy = fsv::parallel{.threads = 4, .grain = 64};
+
+	SECTION("match the sequential results") {
+		auto const no_commas = [](const char& c) { return c != ','; };
+		auto const views = std::vector<fsv::filtered_string_view>{fsv::filtered_string_view{str},
+		                                                          fsv::filtered_string_view{str, fsv::char_class::digits()},
+		                                                          fsv::filtered_string_view{str, no_commas}};
+		for (auto const& sv : views) {
+			auto const expected = static_cast<std::string>(fsv::filtered_string_view{sv});
+			CHECK(fsv::to_string(policy, sv) == expected);
+			CHECK(fsv::size(policy, fsv::filtered_string_view{std::string_view{str}, sv.predicate()}) == expected.size());
+		}
+		auto const typed = fsv::basic_filtered_string_view{str, no_commas};
+		CHECK(fsv::to_string(policy, typed) == static_cast<std::string>(typed));
+	}
+
+	SECTION("remember the size") {
+		auto const sv = fsv::filtered_string_view{str, fsv::char_class::digits()};
+		auto const expected = static_cast<std::string>(sv);
+		auto const copy = fsv::filtered_string_view{std::string_view{str}, sv.predicate()};
+		CHECK(fsv::to_string(policy, copy) == expected);
+		CHECK(copy.size() == expected.size());
+	}
+
+	SECTION("on an empty view") {
+		CHECK(fsv::to_string(policy, fsv::filtered_string_view{}).empty());
+		CHECK(fsv::size(policy, fsv::filtered_string_view{}) == 0);
+	}
+
+	SECTION("rethrow what the predicate throws") {
+		auto const sv = fsv::filtered_string_view{str, [](const char& c) -> bool {
+			                                          if (c == '9') {
+				                                          throw std::runtime_error{"nine"};
+			                                          }
+			                                          return true;
+		                                          }};
+		CHECK_THROWS_AS(fsv::to_string(policy, sv), std::runtime_error);
+		CHECK_THROWS_AS(fsv::size(policy, sv), std::runtime_error);
+	}
+
+	SECTION("rethrow what the predicate throws while the string is being filled") {
+		// keeps everything while the chunks are counted, one call per character, then throws
+		auto calls = std::atomic<std::size_t>{0};
+		auto const sv = fsv::filtered_string_view{str, [&calls, &str](const char&) -> bool {
+			                                          if (calls++ >= str.size()) {
+				                                          throw std::runtime_error{"copying"};
+			                                          }
+			                                          return true;
+		                                          }};
+		CHECK_THROWS_AS(fsv::to_string(policy, sv), std::runtime_error);
+		CHECK(calls > str.size());
+	}
+}
+
+TEST_CASE("parallel split") {
+	// a grain this small puts tokens across chunk boundaries
+	auto const policy = fsv::parallel{.threads = 4, .grain = 3};
+	auto const same_pieces = [](const auto& lhs, const auto& rhs) {
+		return lhs.size() == rhs.size()
+		       and std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const auto& l, const auto& r) {
+			           return l.data() == r.data() and l.size() == r.size() and l == r;
+		           });
+	};
+
+	auto const inputs = std::vector<std::string>{"xax", "aaaaaaaaaaa", "a,b,,c,", ",,,", "ba-a-aa-b-a-a-a", "abababababa", "aaa-aaa"};
+	auto const tokens = std::vector<std::string>{"a", "aa", "aaa", ",", "aba", "ab", "a-a"};
+	auto const no_dashes = [](const char& c) { return c != '-'; };
+	for (auto const& input : inputs) {
+		for (auto const& token : tokens) {
+			auto const tok = fsv::filtered_string_view{token};
+			auto const sv = fsv::filtered_string_view{input};
+			CHECK(same_pieces(fsv::split(policy, sv, tok), fsv::split(sv, tok)));
+			auto const filtered = fsv::basic_filtered_string_view{input, no_dashes};
+			CHECK(same_pieces(fsv::split(policy, filtered, tok), fsv::split(filtered, tok)));
+		}
+	}
+
+	SECTION("over a larger csv-like input") {
+		auto csv = std::string{};
+		for (auto i = 0; i < 2000; ++i) {
+			csv += std::to_string(i * 7919 % 1000) + (i % 10 == 9 ? ",\n" : ", ");
+		}
+		auto const sv = fsv::filtered_string_view{csv, [](const char& c) { return c != ' '; }};
+		auto const tok = fsv::filtered_string_view{","};
+		for (auto const threads : {2, 3, 8}) {
+			auto const pieces = fsv::split(fsv::parallel{.threads = static_cast<std::size_t>(threads), .grain = 16}, sv, tok);
+			CHECK(pieces.size() == 2001);
+			CHECK(same_pieces(pieces, fsv::split(sv, tok)));
+		}
+	}
+}
+
+TEST_CASE("comparisons agree with std::string") {
+	auto const inputs = std::vector<std::string>{"",
+	                                             "a",
+	                                             "ab",
+	                                             "a-b",
+	                                             "abc",
+	                                             "ab\xff",
+	                                             "a\x80-c",
+	                                             "b",
+	                                             std::string(5000, 'x') + "a",
+	                                             std::string(5000, 'x') + "-b",
+	                                             std::string(5000, 'x')};
+	auto const no_dashes = [](const char& c) { return c != '-'; };
+	auto const predicates = std::vector<fsv::filter>{fsv::true_predicate{},
+	                                                 ~fsv::char_class{std::string_view{"-"}},
+	                                                 no_dashes,
+	                                                 fsv::char_class::lower()};
+	auto views = std::vector<fsv::filtered_string_view>{};
+	for (auto const& input : inputs) {
+		for (auto const& pred : predicates) {
+			views.emplace_back(input, pred);
+		}
+	}
+	// every pair of views, with the ones which disagree collected so a failure shows them
+	auto disagreements = std::vector<std::pair<std::string, std::string>>{};
+	for (auto const& lhs : views) {
+		for (auto const& rhs : views) {
+			auto const l = static_cast<std::string>(lhs);
+			auto const r = static_cast<std::string>(rhs);
+			if ((lhs <=> rhs) != (l <=> r) or (lhs == rhs) != (l == r)) {
+				disagreements.emplace_back(l, r);
+			}
+		}
+	}
+	CHECK(disagreements.empty());
+
+	SECTION("statically typed views") {
+		auto const lhs = fsv::basic_filtered_string_view{"a-b-c", no_dashes};
+		auto const rhs = fsv::basic_filtered_string_view{"abd", no_dashes};
+		CHECK(lhs < rhs);
+		CHECK(lhs == lhs);
+		CHECK(fsv::substr(rhs, 0, 2) == fsv::basic_filtered_string_view{"a--b", no_dashes});
+	}
+
+	SECTION("copies compare equal without calling the predicate") {
+		auto calls = 0;
+		auto const sv = fsv::filtered_string_view{"abc", [&calls](const char&) {
+			                                          ++calls;
+			                                          return true;
+		                                          }};
+		auto const copy = sv;
+		CHECK(sv == copy);
+		CHECK(calls == 0);
+	}
+}
+
+TEST_CASE("hashing") {
+	auto const hash = fsv::hash{};
+
+	SECTION("known XXH64 digests") {
+		CHECK(hash(std::string_view{""}) == 0xef46db3751d8e999u);
+		CHECK(hash(std::string_view{"a"}) == 0xd24ec4f1a98c6e5bu);
+	}
+
+	SECTION("views hash like the string of their kept characters, whatever the predicate") {
+		auto str = std::string{};
+		for (auto i = 0; i < 700; ++i) {
+			str.append("k").append(std::to_string(i)).append("-");
+		}
+		auto const no_dashes = [](const char& c) { return c != '-'; };
+		auto const expected = static_cast<std::string>(fsv::filtered_string_view{str, no_dashes});
+		CHECK(hash(fsv::filtered_string_view{str, no_dashes}) == hash(expected));
+		CHECK(hash(fsv::basic_filtered_string_view{str, no_dashes}) == hash(expected));
+		CHECK(hash(fsv::filtered_string_view{str, ~fsv::char_class{std::string_view{"-"}}}) == hash(expected));
+		CHECK(hash(fsv::filtered_string_view{expected}) == hash(expected));
+		CHECK(std::hash<fsv::filtered_string_view>{}(fsv::filtered_string_view{str, no_dashes}) == hash(expected));
+		CHECK(hash(fsv::filtered_string_view{"abc"}) != hash(fsv::filtered_string_view{"abd"}));
+	}
+
+	SECTION("heterogeneous lookup") {
+		auto counts = std::unordered_map<std::string, int, fsv::hash, fsv::equal_to>{{"cat", 1}, {"dog", 2}};
+		auto const found = counts.find(fsv::filtered_string_view{"c.a.t", [](const char& c) { return c != '.'; }});
+		REQUIRE(found != counts.end());
+		CHECK(found->second == 1);
+		CHECK(counts.find(fsv::filtered_string_view{"cow"}) == counts.end());
+
+		auto views = std::unordered_set<fsv::filtered_string_view, fsv::hash, fsv::equal_to>{fsv::filtered_string_view{"x-y", [](const char& c) { return c != '-'; }}};
+		CHECK(views.contains(std::string_view{"xy"}));
+		CHECK(views.contains(std::string{"xy"}));
+		CHECK_FALSE(views.contains(std::string_view{"x-y"}));
+	}
+}
+
+namespace {
+	// forwards to new_delete_resource(), counting the allocations
+	class counting_resource : public std::pmr::memory_resource {
+	 public:
+		int allocations = 0;
+
+	 private:
+		auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override {
+			++allocations;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+
+		auto do_deallocate(void* p, std::size_t bytes, std::size_t alignment) -> void override {
+			std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+
+		auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+			return this == &other;
+		}
+	};
+
+	// a range of views which can only be walked once
+	struct one_pass {
+		struct iterator {
+			using value_type = fsv::filtered_string_view;
+			using difference_type = std::ptrdiff_t;
+
+			auto operator*() const -> const fsv::filtered_string_view& {
+				return *it;
+			}
+
+			auto operator++() -> iterator& {
+				++it;
+				return *this;
+			}
+
+			auto operator++(int) -> void {
+				++it;
+			}
+
+			auto operator==(std::default_sentinel_t) const -> bool {
+				return it == last;
+			}
+
+			std::vector<fsv::filtered_string_view>::const_iterator it;
+			std::vector<fsv::filtered_string_view>::const_iterator last;
+		};
+
+		auto begin() const -> iterator {
+			return {views.begin(), views.end()};
+		}
+
+		auto end() const -> std::default_sentinel_t {
+			return std::default_sentinel;
+		}
+
+		std::vector<fsv::filtered_string_view> views;
+	};
+
+	// whether a range of views can be materialized into an arena
+	template<typename Views>
+	concept materializable = requires(std::pmr::memory_resource& arena, const Views& views) {
+		fsv::materialize_into(arena, views);
+	};
+} // namespace
+
+TEST_CASE("materializing into an arena") {
+	auto const no_dots = [](const char& c) { return c != '.'; };
+
+	SECTION("a list of views is copied contiguously") {
+		auto arena = std::pmr::monotonic_buffer_resource{};
+		auto const [first, second, third] = fsv::materialize_into(arena,
+		                                                          fsv::filtered_string_view{"a.b.c", no_dots},
+		                                                          fsv::basic_filtered_string_view{"d.e", no_dots},
+		                                                          fsv::filtered_string_view{});
+		CHECK(first == "abc");
+		CHECK(second == "de");
+		CHECK(third.empty());
+		CHECK(second.data() == first.data() + 3);
+	}
+
+	SECTION("split into an arena makes one block for all the pieces") {
+		auto str = std::string{};
+		for (auto i = 0; i < 1000; ++i) {
+			str.append("to.ken").append(std::to_string(i)).append(",");
+		}
+		auto const sv = fsv::filtered_string_view{str, no_dots};
+		auto const tok = fsv::filtered_string_view{","};
+
+		auto upstream = counting_resource{};
+		auto arena = std::pmr::monotonic_buffer_resource{1 << 16, &upstream};
+		auto const pieces = fsv::split(arena, sv, tok);
+		auto const expected = fsv::split(sv, tok);
+		REQUIRE(pieces.size() == expected.size());
+		auto const mismatches = std::ranges::count_if(std::views::iota(std::size_t{0}, pieces.size()), [&](std::size_t i) {
+			return pieces[i] != static_cast<std::string>(expected[i]);
+		});
+		CHECK(mismatches == 0);
+		CHECK(pieces[1].data() == pieces[0].data() + pieces[0].size());
+		// the pieces and the growing vector of string_views, not one allocation per piece
+		CHECK(upstream.allocations < 10);
+
+		auto const again = fsv::materialize_into(arena, expected);
+		CHECK(std::ranges::equal(again, pieces));
+	}
+
+	SECTION("a range of views must be multi-pass") {
+		static_assert(std::ranges::input_range<one_pass>);
+		static_assert(not materializable<one_pass>);
+
+		// a forward range without a size works
+		auto const views = std::forward_list<fsv::filtered_string_view>{fsv::filtered_string_view{"a.b", no_dots},
+		                                                                fsv::filtered_string_view{"cd"}};
+		auto arena = std::pmr::monotonic_buffer_resource{};
+		auto const strs = fsv::materialize_into(arena, views);
+		REQUIRE(strs.size() == 2);
+		CHECK(strs[0] == "ab");
+		CHECK(strs[1] == "cd");
+		CHECK(strs[1].data() == strs[0].data() + 2);
+	}
+
+	SECTION("copy") {
+		auto const sv = fsv::filtered_string_view{"h.e.l.l.o", no_dots};
+		auto buffer = std::array<char, 8>{};
+		CHECK(sv.copy(buffer.data(), 3, 1) == 3);
+		CHECK(std::string_view{buffer.data(), 3} == "ell");
+		CHECK(sv.copy(buffer.data(), fsv::filtered_string_view::npos, 3) == 2);
+		CHECK(std::string_view{buffer.data(), 2} == "lo");
+		CHECK_THROWS_AS(sv.copy(buffer.data(), 1, 6), std::domain_error);
+	}
+}
+
+namespace {
+	constexpr auto not_space = [](const char& c) { return c != ' '; };
+	constexpr auto config = fsv::basic_filtered_string_view{"port = 8080 ; host = local", not_space};
+	constexpr auto header = fsv::basic_filtered_string_view{"Content-Type: text/plain", ~fsv::char_class{" :-/"}};
+
+	// the kept characters of a view, copied into a table at compile time
+	template<std::size_t N, typename View>
+	constexpr auto filtered_table(const View& view) {
+		auto table = std::array<char, N>{};
+		view.copy(table.data(), N);
+		return table;
+	}
+
+	constexpr auto header_table = filtered_table<header.size()>(header);
+} // namespace
+
+TEST_CASE("constant expressions") {
+	SECTION("size, subscript and iteration") {
+		static_assert(config.size() == 20);
+		static_assert(config[4] == '=');
+		static_assert(std::ranges::count(config, '=') == 2);
+		static_assert(*std::prev(config.end()) == 'l');
+		static_assert(header.size() == 20);
+		static_assert(std::string_view{header_table.data(), header_table.size()} == "ContentTypetextplain");
+		CHECK(config.size() == 20);
+		CHECK(static_cast<std::string>(header) == "ContentTypetextplain");
+	}
+
+	SECTION("comparisons") {
+		static_assert(config == fsv::basic_filtered_string_view{"port=8080;host=local", not_space});
+		static_assert(config < fsv::basic_filtered_string_view{"port = 9", not_space});
+		static_assert(header != fsv::basic_filtered_string_view{"Content Type", header.predicate()});
+		static_assert((header <=> fsv::basic_filtered_string_view{"Content-Type: text/plain!", header.predicate()}) < 0);
+	}
+
+	SECTION("substr and split") {
+		static_assert(fsv::substr(config, 5, 4) == fsv::basic_filtered_string_view{"8080", not_space});
+		static_assert(fsv::substr(header, 7, 4).size() == 4);
+		static_assert(fsv::split(config, fsv::basic_filtered_string_view{";", not_space}).size() == 2);
+		static_assert(fsv::split(config, fsv::basic_filtered_string_view{";", not_space})[1]
+		              == fsv::basic_filtered_string_view{"host=local", not_space});
+		static_assert(fsv::split(header, fsv::basic_filtered_string_view<fsv::true_predicate>{"t"}).size() == 5);
+
+		// views made at compile time still work at runtime, without a stale size
+		constexpr auto port = fsv::substr(config, 5, 4);
+		CHECK(port.size() == 4);
+		CHECK(static_cast<std::string>(port) == "8080");
+	}
+}
+
+TEST_CASE("with_runs") {
+	auto const printable = [](const char& c) { return c >= ' '; };
+	auto str = std::string{};
+	auto expected = std::string{};
+	for (auto i = 0; i < 300; ++i) {
+		auto const line = "line " + std::to_string(i);
+		str.append(line).append(i % 4 == 0 ? "\r\n" : "\n");
+		expected += line;
+	}
+	auto const plain = fsv::filtered_string_view{str, printable};
+	auto const runs = plain.with_runs();
+	CHECK_FALSE(plain.has_runs());
+	CHECK(runs.has_runs());
+
+	SECTION("gives the same answers as the view without runs") {
+		CHECK(runs.size() == expected.size());
+		CHECK(static_cast<std::string>(runs) == expected);
+		auto os = std::ostringstream{};
+		os << runs;
+		CHECK(os.str() == expected);
+		CHECK(&runs[1000] == &plain[1000]);
+		CHECK(static_cast<std::string>(fsv::substr(runs, 995, 40)) == expected.substr(995, 40));
+		CHECK(static_cast<std::string>(fsv::substr(runs, 2000)) == expected.substr(2000));
+		CHECK_THROWS_AS(runs.at(static_cast<int>(expected.size())), std::domain_error);
+	}
+
+	SECTION("copy cuts the runs at both ends") {
+		auto buffer = std::string(30, '\0');
+		CHECK(runs.copy(buffer.data(), 30, 3) == 30);
+		CHECK(buffer == expected.substr(3, 30));
+	}
+
+	SECTION("compares against views with and without runs") {
+		auto const same = fsv::filtered_string_view{expected};
+		CHECK(runs == plain);
+		CHECK(runs == same);
+		CHECK(same == runs);
+		CHECK(runs == same.with_runs());
+		auto const longer_str = expected + "!";
+		auto const longer = fsv::filtered_string_view{longer_str};
+		CHECK(runs < longer.with_runs());
+		CHECK(runs < fsv::filtered_string_view{expected + "!", printable});
+		CHECK(fsv::filtered_string_view{"line 0line 2"}.with_runs() > runs);
+	}
+
+	SECTION("copies share the runs") {
+		auto const copy = runs;
+		CHECK(copy.has_runs());
+		CHECK(static_cast<std::string>(copy) == expected);
+	}
+
+	SECTION("on an empty view") {
+		auto const empty = fsv::filtered_string_view{}.with_runs();
+		CHECK(empty.size() == 0);
+		CHECK(static_cast<std::string>(empty).empty());
+		CHECK(empty == fsv::filtered_string_view{"\n\n", printable}.with_runs());
+	}
+}
+
+TEST_CASE("write_to a stream") {
+	auto const no_dots = [](const char& c) { return c != '.'; };
+
+	SECTION("writes the kept characters unformatted") {
+		auto os = std::ostringstream{};
+		os.width(20);
+		fsv::write_to(os, fsv::filtered_string_view{"a.b.c", no_dots});
+		fsv::write_to(os, fsv::basic_filtered_string_view{"x1y2", fsv::char_class::digits()});
+		fsv::write_to(os, fsv::filtered_string_view{"d.e", no_dots}.with_runs());
+		CHECK(os.str() == "abc12de");
+	}
+
+	SECTION("many views with a separator") {
+		auto const records = fsv::split(fsv::filtered_string_view{"k.1=v1;k2=v.2;", no_dots}, fsv::filtered_string_view{";"});
+		auto os = std::ostringstream{};
+		fsv::write_to(os, records, "\n");
+		CHECK(os.str() == "k1=v1\nk2=v2\n\n");
+	}
+
+	SECTION("a stream buffer taking less sets badbit") {
+		// a stream buffer without room, which takes no characters
+		struct full_buffer : std::streambuf {};
+		auto buffer = full_buffer{};
+		auto os = std::ostream{&buffer};
+		CHECK_FALSE(fsv::write_to(os, fsv::filtered_string_view{"abc"}));
+		CHECK(os.bad());
+	}
+}
+
+TEST_CASE("from_chars") {
+	auto const no_commas = [](const char& c) { return c != ','; };
+
+	SECTION("parses integers with and without characters filtered out") {
+		auto n = 0;
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"1234"}, n) == fsv::from_chars_result{4, std::errc{}});
+		CHECK(n == 1234);
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"-1,234,567", no_commas}, n)
+		      == fsv::from_chars_result{8, std::errc{}});
+		CHECK(n == -1234567);
+		auto const digits = fsv::basic_filtered_string_view{"(02) 9385 1000", fsv::char_class::digits()};
+		auto big = std::int64_t{0};
+		CHECK(fsv::from_chars(digits, big).count == 10);
+		CHECK(big == 293851000);
+	}
+
+	SECTION("stops at the first kept character which is not part of the number") {
+		auto n = 0u;
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"4,2x7", no_commas}, n)
+		      == fsv::from_chars_result{2, std::errc{}});
+		CHECK(n == 42);
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"ff,ff;", no_commas}, n, 16).count == 4);
+		CHECK(n == 0xffff);
+	}
+
+	SECTION("reports errors as std::from_chars does, leaving the value alone") {
+		auto n = std::int8_t{7};
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"1,000", no_commas}, n)
+		      == fsv::from_chars_result{4, std::errc::result_out_of_range});
+		CHECK(fsv::from_chars(fsv::filtered_string_view{",x1", no_commas}, n)
+		      == fsv::from_chars_result{0, std::errc::invalid_argument});
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"+1"}, n).ec == std::errc::invalid_argument);
+		CHECK(fsv::from_chars(fsv::filtered_string_view{",,", no_commas}, n).ec == std::errc::invalid_argument);
+		auto u = 3u;
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"-1", no_commas}, u).ec == std::errc::invalid_argument);
+		CHECK(n == 7);
+		CHECK(u == 3);
+	}
+
+	SECTION("numbers longer than the stack buffer") {
+		auto const str = std::string(300, '0') + "42,";
+		auto n = 0;
+		CHECK(fsv::from_chars(fsv::filtered_string_view{str, no_commas}, n) == fsv::from_chars_result{302, std::errc{}});
+		CHECK(n == 42);
+	}
+
+	SECTION("a short number followed by many kept characters allocates nothing") {
+		auto const str = "7," + std::string(200, 'x');
+		auto const sv = fsv::filtered_string_view{str, no_commas};
+		auto n = 0;
+		auto d = 0.0;
+		// numbers longer than the stack buffer are gathered from the default memory resource
+		auto counting = counting_resource{};
+		auto* const previous = std::pmr::set_default_resource(&counting);
+		auto const int_result = fsv::from_chars(sv, n);
+		auto const float_result = fsv::from_chars(sv, d);
+		auto const short_allocations = counting.allocations;
+		auto long_value = 0.0;
+		auto const long_str = std::string(200, '1') + ",";
+		auto const long_result = fsv::from_chars(fsv::filtered_string_view{long_str, no_commas}, long_value);
+		std::pmr::set_default_resource(previous);
+		CHECK(short_allocations == 0);
+		CHECK(counting.allocations != 0);
+		CHECK(int_result == fsv::from_chars_result{1, std::errc{}});
+		CHECK(n == 7);
+		CHECK(float_result == fsv::from_chars_result{1, std::errc{}});
+		CHECK(d == 7.0);
+		CHECK(long_result == fsv::from_chars_result{200, std::errc{}});
+	}
+
+	SECTION("a number cut short by the end of the stack buffer") {
+		// the buffer ends after "1e", which on its own would parse as 1
+		auto d = 0.0;
+		CHECK(fsv::from_chars(fsv::filtered_string_view{std::string(126, '0') + "1e,5", no_commas}, d)
+		      == fsv::from_chars_result{129, std::errc{}});
+		CHECK(d == 1e5);
+		CHECK(fsv::from_chars(fsv::filtered_string_view{std::string(125, '0') + "inf,inity", no_commas}, d).count
+		      == 125);
+		auto const nan = "nan(" + std::string(130, 'x') + "),";
+		CHECK(fsv::from_chars(fsv::filtered_string_view{nan, no_commas}, d).count == nan.size() - 1);
+		CHECK(std::isnan(d));
+
+		// a longer parse which fails leaves the value alone
+		auto n = std::int8_t{5};
+		CHECK(fsv::from_chars(fsv::filtered_string_view{std::string(127, '0') + "1,000", no_commas}, n).ec
+		      == std::errc::result_out_of_range);
+		CHECK(n == 5);
+	}
+
+	SECTION("parses floating point numbers") {
+		auto d = 0.0;
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"3.25"}, d) == fsv::from_chars_result{4, std::errc{}});
+		CHECK(d == 3.25);
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"-1,250.5e-1;", no_commas}, d).count == 10);
+		CHECK(d == -125.05);
+		auto f = 0.0f;
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"1.8p,1", no_commas}, f, std::chars_format::hex).count == 5);
+		CHECK(f == 3.0f);
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"e5"}, d).ec == std::errc::invalid_argument);
+		CHECK(fsv::from_chars(fsv::filtered_string_view{"1e,999", no_commas}, d).ec == std::errc::result_out_of_range);
+	}
+
+	SECTION("fields from split") {
+		auto const fields = fsv::split(fsv::filtered_string_view{"1, 2,3 , 40", [](const char& c) { return c != ' '; }},
+		                               fsv::filtered_string_view{","});
+		auto sum = 0;
+		for (auto const& field : fields) {
+			auto n = 0;
+			auto const [count, ec] = fsv::from_chars(field, n);
+			REQUIRE(ec == std::errc{});
+			CHECK(count == field.size());
+			sum += n;
+		}
+		CHECK(sum == 46);
+	}
+}
+
+TEST_CASE("multi_matcher") {
+	auto const no_dots = [](const char& c) { return c != '.'; };
+	// the pattern, position and raw offset of every match, and the kept characters of its view
+	auto const summary = [](const auto& matches) {
+		auto str = std::string{};
+		for (auto const& match : matches) {
+			str += std::to_string(match.pattern) + "@" + std::to_string(match.pos) + "/" + std::to_string(match.offset)
+			       + "=" + static_cast<std::string>(match.view) + " ";
+		}
+		return str;
+	};
+
+	SECTION("finds every pattern, overlapping ones included, longest first") {
+		auto const matcher = fsv::multi_matcher{"he", "she", "his", "hers"};
+		REQUIRE(matcher.pattern_count() == 4);
+		CHECK(matcher.pattern(3) == "hers");
+		CHECK(summary(matcher.find_all(fsv::filtered_string_view{"ushers"})) == "1@1/1=she 0@2/2=he 3@2/2=hers ");
+		CHECK(matcher.find_all(fsv::filtered_string_view{"no match"}).empty());
+	}
+
+	SECTION("matches across filtered out characters") {
+		auto const matcher = fsv::multi_matcher{"error", "err", "or."};
+		auto const sv = fsv::filtered_string_view{"an er.ror. e.r.r", no_dots};
+		auto const matches = matcher.find_all(sv);
+		CHECK(summary(matches) == "1@3/3=err 0@3/3=error 1@9/11=err ");
+		REQUIRE(matches.size() == 3);
+		CHECK(matches[1].view.data() == sv.data() + 3);
+		CHECK(matches[1].view.size() == 5);
+		CHECK(static_cast<std::string>(fsv::substr(sv, static_cast<int>(matches[2].pos), 3)) == "err");
+	}
+
+	SECTION("with a char_class, runs or an inline predicate") {
+		auto const matcher = fsv::multi_matcher{"abc", "cab"};
+		auto const str = std::string{"a-b-c-a-b ab,c"};
+		auto const letters = fsv::basic_filtered_string_view{str, fsv::char_class::alpha()};
+		CHECK(summary(matcher.find_all(letters)) == "0@0/0=abc 1@2/4=cab 0@5/10=abc ");
+		auto const runs = fsv::filtered_string_view{str, fsv::filter{fsv::char_class::alpha()}}.with_runs();
+		CHECK(summary(matcher.find_all(runs)) == summary(matcher.find_all(letters)));
+		auto const inline_lambda = fsv::basic_filtered_string_view{str, [](const char& c) { return c != '-'; }};
+		CHECK(summary(matcher.find_all(inline_lambda)) == "0@0/0=abc 1@2/4=cab ");
+	}
+
+	SECTION("duplicate, empty and non-ascii patterns") {
+		auto const patterns = std::vector<std::string>{"", "\xff\x01", "x", "x"};
+		auto const matcher = fsv::multi_matcher{patterns};
+		auto const str = std::string{"\xff.\x01x"};
+		CHECK(summary(matcher.find_all(fsv::filtered_string_view{str, no_dots})) == "1@0/0=\xff\x01 2@2/3=x 3@2/3=x ");
+	}
+
+	SECTION("agrees with repeated find") {
+		auto const patterns = std::vector<std::string>{"ab", "ba", "aab", "bab", "abba", "b"};
+		auto const matcher = fsv::multi_matcher{patterns};
+		auto str = std::string{};
+		for (auto i = 0u; i < 500; ++i) {
+			str += "ab. "[(i * 7 + i / 3) % 4];
+		}
+		auto const sv = fsv::filtered_string_view{str, no_dots};
+		auto expected = std::multiset<std::pair<std::size_t, std::size_t>>{};
+		for (auto p = std::size_t{0}; p < patterns.size(); ++p) {
+			for (auto pos = sv.find(patterns[p]); pos != sv.npos; pos = sv.find(patterns[p], pos + 1)) {
+				expected.emplace(p, pos);
+			}
+		}
+		auto found = std::multiset<std::pair<std::size_t, std::size_t>>{};
+		matcher.for_each_match(sv, [&found](const fsv::pattern_match<fsv::filter>& match) {
+			found.emplace(match.pattern, match.pos);
+			CHECK(match.view == fsv::substr(match.view, 0, static_cast<int>(match.view.size())));
+		});
+		CHECK(found == expected);
+	}
+}
+
+TEST_CASE("sort") {
+	auto const no_dots = [](const char& c) { return c != '.'; };
+	// whether views is in the order std::ranges::sort puts it in, equal views compared alike
+	auto const sorted_like_std = [](const auto& views) {
+		auto expected = views;
+		std::ranges::sort(expected);
+		return std::ranges::equal(views, expected, [](const auto& lhs, const auto& rhs) { return lhs == rhs; });
+	};
+
+	SECTION("orders by the kept characters, as operator<=> does") {
+		auto const strs = std::vector<std::string>{"b.anana", "apple", "app.le.pie", "", "...", "apple pie", "a"};
+		auto views = std::vector<fsv::filtered_string_view>{};
+		for (auto const& str : strs) {
+			views.emplace_back(str, no_dots);
+		}
+		fsv::sort(views);
+		auto sorted = std::vector<std::string>{};
+		for (auto const& view : views) {
+			sorted.push_back(static_cast<std::string>(view));
+		}
+		CHECK(sorted == std::vector<std::string>{"", "", "a", "apple", "apple pie", "applepie", "banana"});
+	}
+
+	SECTION("long common prefixes, NULs and bytes above 0x7f") {
+		auto const strs = std::vector<std::string>{std::string{"prefix..\0", 9},
+		                                           "prefix..",
+		                                           std::string{"prefix\0\0\0", 9},
+		                                           "prefix\xff",
+		                                           "prefix..9",
+		                                           "prefix.123456789b",
+		                                           "prefix123456789a",
+		                                           "prefix1234567"};
+		auto views = std::vector<fsv::filtered_string_view>{};
+		for (auto const& str : strs) {
+			views.emplace_back(str, no_dots);
+		}
+		auto const unsorted = views;
+		fsv::sort(views);
+		CHECK(sorted_like_std(views));
+		CHECK(static_cast<std::string>(views.front()) == "prefix");
+		CHECK(static_cast<std::string>(views.back()) == "prefix\xff");
+		CHECK(std::ranges::is_permutation(views, unsorted));
+	}
+
+	SECTION("many views, through the radix passes") {
+		auto str = std::string{};
+		auto state = 12345u;
+		for (auto i = 0; i < 20000; ++i) {
+			state = state * 1664525u + 1013904223u;
+			// a few shared prefixes, so that buckets both split and stay whole
+			str += "abc."[(state >> 16) % 4];
+			if ((state >> 20) % 16 == 0) {
+				str += ',';
+			}
+		}
+		auto views = fsv::split(fsv::filtered_string_view{str, no_dots}, fsv::filtered_string_view{","});
+		REQUIRE(views.size() > 500);
+		fsv::sort(views);
+		CHECK(sorted_like_std(views));
+
+		auto classes = std::vector<fsv::basic_filtered_string_view<fsv::char_class>>{};
+		for (auto i = std::size_t{0}; i + 12 < str.size(); i += 7) {
+			classes.emplace_back(str.data() + i, 12, ~fsv::char_class{"b"});
+		}
+		fsv::sort(std::span{classes});
+		CHECK(sorted_like_std(classes));
+	}
+
+	SECTION("views with runs, and nothing to sort") {
+		auto views = std::vector<fsv::filtered_string_view>{fsv::filtered_string_view{"c.b", no_dots}.with_runs(),
+		                                                    fsv::filtered_string_view{"b.c", no_dots}.with_runs(),
+		                                                    fsv::filtered_string_view{"cb"}};
+		fsv::sort(views);
+		CHECK(static_cast<std::string>(views[0]) == "bc");
+		CHECK(views[1] == views[2]);
+		auto none = std::vector<fsv::filtered_string_view>{};
+		fsv::sort(none);
+		CHECK(none.empty());
+	}
+}
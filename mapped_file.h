@@ -0,0 +1,113 @@
+#ifndef COMP6771_ASS2_MAPPED_FILE_H
+#define COMP6771_ASS2_MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fsv {
+	// a read-only memory mapping of a whole file, unmapped on destruction. its contents can be viewed
+	// without copying through the (const char*, std::size_t, filter) constructor of a filtered view, e.g.
+	//
+	//     auto const file = fsv::mapped_file{"corpus.txt"};
+	//     auto const words = fsv::filtered_string_view{file.data(), file.size(), fsv::char_class::alpha()};
+	//
+	// views must not outlive the mapping. the pages are read ahead sequentially, which suits the
+	// front-to-back scans of the views.
+	class mapped_file {
+	 public:
+		mapped_file() noexcept = default;
+
+		// throws std::system_error if the file cannot be opened or mapped
+		explicit mapped_file(const std::string& path) {
+			auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd == -1) {
+				fail("open", path);
+			}
+			struct ::stat st {};
+			if (::fstat(fd, &st) == -1) {
+				auto const error = errno;
+				::close(fd);
+				errno = error;
+				fail("stat", path);
+			}
+			size_ = static_cast<std::size_t>(st.st_size);
+			// mapping an empty file is an error, and there is nothing to map anyway
+			if (size_ != 0) {
+				auto* const addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (addr == MAP_FAILED) {
+					auto const error = errno;
+					::close(fd);
+					errno = error;
+					fail("mmap", path);
+				}
+				data_ = static_cast<const char*>(addr);
+				// the hints are advisory, so failing to apply them is not an error
+				::madvise(addr, size_, MADV_SEQUENTIAL);
+				::madvise(addr, size_, MADV_WILLNEED);
+			}
+			// the mapping stays valid once the descriptor is closed
+			::close(fd);
+		}
+
+		mapped_file(const mapped_file&) = delete;
+		auto operator=(const mapped_file&) -> mapped_file& = delete;
+
+		mapped_file(mapped_file&& other) noexcept
+		: data_{std::exchange(other.data_, nullptr)}
+		, size_{std::exchange(other.size_, 0)} {}
+
+		auto operator=(mapped_file&& other) noexcept -> mapped_file& {
+			if (this != &other) {
+				unmap();
+				data_ = std::exchange(other.data_, nullptr);
+				size_ = std::exchange(other.size_, 0);
+			}
+			return *this;
+		}
+
+		~mapped_file() noexcept {
+			unmap();
+		}
+
+		auto data() const noexcept -> const char* {
+			return data_;
+		}
+
+		auto size() const noexcept -> std::size_t {
+			return size_;
+		}
+
+		auto empty() const noexcept -> bool {
+			return size_ == 0;
+		}
+
+		explicit operator std::string_view() const noexcept {
+			return {data_, size_};
+		}
+
+	 private:
+		const char* data_ = nullptr;
+		std::size_t size_ = 0;
+
+		auto unmap() noexcept -> void {
+			if (data_ != nullptr) {
+				::munmap(const_cast<char*>(data_), size_);
+			}
+		}
+
+		[[noreturn]] static auto fail(const char* what, const std::string& path) -> void {
+			throw std::system_error{errno, std::generic_category(), std::string{"mapped_file: "} + what + " " + path};
+		}
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_MAPPED_FILE_H
@@ -0,0 +1,65 @@
+#include "./filtered_string_view.h"
+#include "./mapped_file.h"
+
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+	// a file in the temporary directory which is removed when the test is done with it
+	struct temp_file {
+		explicit temp_file(const std::string& contents)
+		: path{std::filesystem::temp_directory_path() / ("fsv_mapped_file_" + std::to_string(::getpid()))} {
+			auto os = std::ofstream{path, std::ios::binary};
+			os.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+		}
+
+		~temp_file() {
+			std::filesystem::remove(path);
+		}
+
+		std::filesystem::path path;
+	};
+} // namespace
+
+TEST_CASE("mapped_file") {
+	SECTION("a mapped file can be filtered without a copy, NULs included") {
+		auto const contents = std::string{"key\0value\0other key\0other value", 31};
+		auto const file = temp_file{contents};
+		auto const mapped = fsv::mapped_file{file.path.string()};
+		REQUIRE(mapped.size() == contents.size());
+		CHECK(static_cast<std::string_view>(mapped) == contents);
+
+		auto const sv = fsv::filtered_string_view{mapped.data(), mapped.size(), [](const char& c) { return c != ' '; }};
+		CHECK(sv.data() == mapped.data());
+		CHECK(static_cast<std::string>(sv) == std::string{"key\0value\0otherkey\0othervalue", 29});
+
+		auto const fields = fsv::split(sv, fsv::filtered_string_view{std::string{"\0", 1}});
+		REQUIRE(fields.size() == 4);
+		CHECK(static_cast<std::string>(fields[2]) == "otherkey");
+	}
+
+	SECTION("an empty file maps to an empty range") {
+		auto const file = temp_file{""};
+		auto const mapped = fsv::mapped_file{file.path.string()};
+		CHECK(mapped.empty());
+		CHECK(fsv::filtered_string_view{mapped.data(), mapped.size(), fsv::char_class::alpha()}.size() == 0);
+	}
+
+	SECTION("moving transfers the mapping") {
+		auto const file = temp_file{"abc"};
+		auto mapped = fsv::mapped_file{file.path.string()};
+		auto const data = mapped.data();
+		auto moved = std::move(mapped);
+		CHECK(moved.data() == data);
+		CHECK(mapped.data() == nullptr);
+		CHECK(mapped.size() == 0);
+	}
+
+	SECTION("a missing file throws") {
+		CHECK_THROWS_AS(fsv::mapped_file{"/nonexistent/fsv/mapped_file"}, std::system_error);
+	}
+}